@@ -0,0 +1,110 @@
+#include <stdlib.h>
+
+#include "arena.h"
+#include "harness.h"
+#include "hugepage.h"
+
+/* Chunk header, padded so that the space after it stays granule-aligned */
+struct arena_chunk {
+    struct arena_chunk *next;
+    /* Bytes of the huge page region holding the chunk, 0 if malloc'ed */
+    size_t huge;
+} __attribute__((aligned(ARENA_GRANULE)));
+
+void arena_init(struct arena *a)
+{
+    a->chunks = NULL;
+    a->bump = a->bump_end = NULL;
+    for (int i = 0; i < ARENA_BINS; i++)
+        a->bins[i] = NULL;
+    a->used = 0;
+    a->huge = false;
+}
+
+/* Put a granule-aligned block on the list of its size class */
+static void arena_bin(struct arena *a, void *p, size_t size)
+{
+    size_t cls = size / ARENA_GRANULE - 1;
+    *(void **) p = a->bins[cls];
+    a->bins[cls] = p;
+}
+
+/* Start a new chunk with data bytes of room */
+static bool arena_grow(struct arena *a, size_t data)
+{
+    size_t huge = huge_round(sizeof(struct arena_chunk) + data);
+    struct arena_chunk *c = a->huge ? huge_alloc(huge) : NULL;
+    if (c) {
+        /* The whole region is room */
+        data = huge - sizeof(struct arena_chunk);
+    } else {
+        c = malloc(sizeof(struct arena_chunk) + data);
+        if (!c)
+            return false;
+        huge = 0;
+    }
+    c->huge = huge;
+
+    /* Keep what is left of the current chunk as holes */
+    size_t room = (a->bump_end - a->bump) & ~((size_t) ARENA_GRANULE - 1);
+    while (room) {
+        size_t piece = room > ARENA_MAX_ALLOC ? ARENA_MAX_ALLOC : room;
+        arena_bin(a, a->bump, piece);
+        a->bump += piece;
+        room -= piece;
+    }
+
+    c->next = a->chunks;
+    a->chunks = c;
+    a->bump = (char *) (c + 1);
+    a->bump_end = a->bump + data;
+    return true;
+}
+
+bool arena_reserve(struct arena *a, size_t size)
+{
+    if ((size_t) (a->bump_end - a->bump) >= size)
+        return true;
+    return arena_grow(a, arena_round(size));
+}
+
+void *arena_alloc(struct arena *a, size_t size)
+{
+    size = arena_round(size);
+    void **bin = &a->bins[size / ARENA_GRANULE - 1];
+    void *p = *bin;
+    if (p) {
+        *bin = *(void **) p;
+    } else {
+        if ((size_t) (a->bump_end - a->bump) < size &&
+            !arena_grow(a, ARENA_CHUNK_SIZE - sizeof(struct arena_chunk)))
+            return NULL;
+        p = a->bump;
+        a->bump += size;
+    }
+    a->used += size;
+    return p;
+}
+
+void arena_free(struct arena *a, void *p, size_t size)
+{
+    size = arena_round(size);
+    arena_bin(a, p, size);
+    a->used -= size;
+}
+
+void arena_destroy(struct arena *a)
+{
+    bool huge = a->huge;
+    struct arena_chunk *c = a->chunks;
+    while (c) {
+        struct arena_chunk *next = c->next;
+        if (c->huge)
+            huge_free(c, c->huge);
+        else
+            free(c);
+        c = next;
+    }
+    arena_init(a);
+    a->huge = huge;
+}
@@ -0,0 +1,67 @@
+#ifndef LAB0_ARENA_H
+#define LAB0_ARENA_H
+
+/*
+ * Bump allocator for variable-sized byte strings.
+ *
+ * Requests are rounded up to ARENA_GRANULE and carved from large chunks.
+ * Freed blocks are kept on one list per size class and reused by later
+ * requests of the same class, so removals do not make the arena grow
+ * without bound.  Everything is given back at once by arena_destroy.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_GRANULE 16
+#define ARENA_BINS 64
+
+/* Largest request the arena serves; callers must allocate bigger ones alone */
+#define ARENA_MAX_ALLOC (ARENA_BINS * ARENA_GRANULE)
+
+struct arena_chunk;
+
+struct arena {
+    struct arena_chunk *chunks;
+    char *bump, *bump_end;
+    /* Holes left by arena_free, bins[i] holds blocks of (i + 1) granules */
+    void *bins[ARENA_BINS];
+    /* Bytes handed out and not yet freed, after rounding */
+    size_t used;
+    /*
+     * Take chunks from huge_alloc, rounded up to whole huge pages, falling
+     * back to malloc.  Cleared by arena_init, kept by arena_destroy.
+     */
+    bool huge;
+};
+
+static inline size_t arena_round(size_t size)
+{
+    return (size + ARENA_GRANULE - 1) & ~((size_t) ARENA_GRANULE - 1);
+}
+
+/* Prepare an empty arena.  Allocates nothing. */
+void arena_init(struct arena *a);
+
+/*
+ * Make sure the next size bytes of fresh space are contiguous, so that
+ * allocations adding up to size cannot fail.  If a chunk is needed it is
+ * sized to fit exactly, which may be more or less than ARENA_CHUNK_SIZE.
+ * Return false if the chunk could not be allocated.
+ */
+bool arena_reserve(struct arena *a, size_t size);
+
+/*
+ * Return size bytes, where 0 < size <= ARENA_MAX_ALLOC.
+ * Return NULL if a new chunk was needed and could not be allocated.
+ */
+void *arena_alloc(struct arena *a, size_t size);
+
+/* Return a block obtained from arena_alloc with the same size */
+void arena_free(struct arena *a, void *p, size_t size);
+
+/* Release every chunk at once.  The arena is left empty. */
+void arena_destroy(struct arena *a);
+
+#endif /* LAB0_ARENA_H */
@@ -0,0 +1,574 @@
+#include <string.h>
+
+#include "backend.h"
+#include "iqueue.h"
+#include "queue.h"
+#include "ring.h"
+#include "unrolled.h"
+
+/* How many elements list_remove_head_n takes off the queue at once */
+#define TAKE_BATCH 1024
+
+static void *list_new()
+{
+    return q_new();
+}
+
+static void list_free(void *q)
+{
+    q_free(q);
+}
+
+static bool list_insert_head(void *q, char *s)
+{
+    return q_insert_head(q, s);
+}
+
+static bool list_insert_tail(void *q, char *s)
+{
+    return q_insert_tail(q, s);
+}
+
+static bool list_insert_head_n(void *q, char **s, size_t n)
+{
+    return q_insert_head_n(q, s, n);
+}
+
+static bool list_insert_tail_n(void *q, char **s, size_t n)
+{
+    return q_insert_tail_n(q, s, n);
+}
+
+static bool list_remove_head(void *q, char *sp, size_t bufsize)
+{
+    element_t *e = q_remove_head(q, sp, bufsize);
+    if (!e)
+        return false;
+    q_release_element(e);
+    return true;
+}
+
+static bool list_remove_tail(void *q, char *sp, size_t bufsize)
+{
+    element_t *e = q_remove_tail(q, sp, bufsize);
+    if (!e)
+        return false;
+    q_release_element(e);
+    return true;
+}
+
+static size_t list_remove_head_n(void *q, size_t n)
+{
+    element_t *taken[TAKE_BATCH];
+    size_t removed = 0, cnt;
+    do {
+        size_t want = n - removed < TAKE_BATCH ? n - removed : TAKE_BATCH;
+        cnt = q_take_head_n(q, taken, want);
+        for (size_t i = 0; i < cnt; i++)
+            q_release_element(taken[i]);
+        removed += cnt;
+    } while (cnt && removed < n);
+    return removed;
+}
+
+static size_t list_size(void *q)
+{
+    return q_size(q);
+}
+
+static bool list_delete_mid(void *q)
+{
+    return q_delete_mid(q);
+}
+
+static bool list_delete_dup(void *q)
+{
+    return q_delete_dup(q);
+}
+
+static void list_swap(void *q)
+{
+    q_swap(q);
+}
+
+static void list_reverse(void *q)
+{
+    q_reverse(q);
+}
+
+static void list_sort(void *q)
+{
+    q_sort(q);
+}
+
+/* Point it at node pos of list q, return false at the head */
+static bool list_at(struct list_head *q, struct list_head *pos, q_iter_t *it)
+{
+    it->pos = pos;
+    if (pos == q)
+        return false;
+    element_t *e = list_entry(pos, element_t, list);
+    it->value = e->value;
+    it->len = e->len;
+    return true;
+}
+
+static bool list_first(void *q, q_iter_t *it)
+{
+    return list_at(q, q_next(q, q), it);
+}
+
+static bool list_last(void *q, q_iter_t *it)
+{
+    return list_at(q, q_prev(q, q), it);
+}
+
+static bool list_next(void *q, q_iter_t *it)
+{
+    return list_at(q, q_next(q, it->pos), it);
+}
+
+static bool list_prev(void *q, q_iter_t *it)
+{
+    return list_at(q, q_prev(q, it->pos), it);
+}
+
+const queue_ops_t list_ops = {
+    .name = "list",
+    .new = list_new,
+    .free = list_free,
+    .insert_head = list_insert_head,
+    .insert_tail = list_insert_tail,
+    .insert_head_n = list_insert_head_n,
+    .insert_tail_n = list_insert_tail_n,
+    .remove_head = list_remove_head,
+    .remove_tail = list_remove_tail,
+    .remove_head_n = list_remove_head_n,
+    .size = list_size,
+    .delete_mid = list_delete_mid,
+    .delete_dup = list_delete_dup,
+    .swap = list_swap,
+    .reverse = list_reverse,
+    .sort = list_sort,
+    .first = list_first,
+    .last = list_last,
+    .next = list_next,
+    .prev = list_prev,
+};
+
+static void *unrolled_new()
+{
+    return uq_new();
+}
+
+static void unrolled_free(void *q)
+{
+    uq_free(q);
+}
+
+static bool unrolled_insert_head(void *q, char *s)
+{
+    return uq_insert_head(q, s);
+}
+
+static bool unrolled_insert_tail(void *q, char *s)
+{
+    return uq_insert_tail(q, s);
+}
+
+static bool unrolled_insert_head_n(void *q, char **s, size_t n)
+{
+    return uq_insert_head_n(q, s, n);
+}
+
+static bool unrolled_insert_tail_n(void *q, char **s, size_t n)
+{
+    return uq_insert_tail_n(q, s, n);
+}
+
+static bool unrolled_remove_head(void *q, char *sp, size_t bufsize)
+{
+    return uq_remove_head(q, sp, bufsize);
+}
+
+static bool unrolled_remove_tail(void *q, char *sp, size_t bufsize)
+{
+    return uq_remove_tail(q, sp, bufsize);
+}
+
+static size_t unrolled_remove_head_n(void *q, size_t n)
+{
+    size_t removed = 0;
+    while (removed < n && uq_remove_head(q, NULL, 0))
+        removed++;
+    return removed;
+}
+
+static size_t unrolled_size(void *q)
+{
+    return uq_size(q);
+}
+
+static bool unrolled_delete_mid(void *q)
+{
+    return uq_delete_mid(q);
+}
+
+static bool unrolled_delete_dup(void *q)
+{
+    return uq_delete_dup(q);
+}
+
+static void unrolled_swap(void *q)
+{
+    uq_swap(q);
+}
+
+static void unrolled_reverse(void *q)
+{
+    uq_reverse(q);
+}
+
+static void unrolled_sort(void *q)
+{
+    uq_sort(q);
+}
+
+/* Load position p into it, return false once p has left the queue */
+static bool unrolled_at(struct uq_pos p, q_iter_t *it)
+{
+    it->pos = p.node;
+    it->slot = p.slot;
+    if (!p.node)
+        return false;
+    it->value = uq_value(p);
+    it->len = strlen(it->value);
+    return true;
+}
+
+static bool unrolled_first(void *q, q_iter_t *it)
+{
+    return unrolled_at(uq_first(q), it);
+}
+
+static bool unrolled_last(void *q, q_iter_t *it)
+{
+    return unrolled_at(uq_last(q), it);
+}
+
+static bool unrolled_next(void *q, q_iter_t *it)
+{
+    struct uq_pos p = {it->pos, it->slot};
+    uq_next(q, &p);
+    return unrolled_at(p, it);
+}
+
+static bool unrolled_prev(void *q, q_iter_t *it)
+{
+    struct uq_pos p = {it->pos, it->slot};
+    uq_prev(q, &p);
+    return unrolled_at(p, it);
+}
+
+const queue_ops_t unrolled_ops = {
+    .name = "unrolled",
+    .new = unrolled_new,
+    .free = unrolled_free,
+    .insert_head = unrolled_insert_head,
+    .insert_tail = unrolled_insert_tail,
+    .insert_head_n = unrolled_insert_head_n,
+    .insert_tail_n = unrolled_insert_tail_n,
+    .remove_head = unrolled_remove_head,
+    .remove_tail = unrolled_remove_tail,
+    .remove_head_n = unrolled_remove_head_n,
+    .size = unrolled_size,
+    .delete_mid = unrolled_delete_mid,
+    .delete_dup = unrolled_delete_dup,
+    .swap = unrolled_swap,
+    .reverse = unrolled_reverse,
+    .sort = unrolled_sort,
+    .first = unrolled_first,
+    .last = unrolled_last,
+    .next = unrolled_next,
+    .prev = unrolled_prev,
+};
+
+static void *ring_new()
+{
+    return rq_new();
+}
+
+static void ring_free(void *q)
+{
+    rq_free(q);
+}
+
+static bool ring_insert_head(void *q, char *s)
+{
+    return rq_insert_head(q, s);
+}
+
+static bool ring_insert_tail(void *q, char *s)
+{
+    return rq_insert_tail(q, s);
+}
+
+static bool ring_insert_head_n(void *q, char **s, size_t n)
+{
+    return rq_insert_head_n(q, s, n);
+}
+
+static bool ring_insert_tail_n(void *q, char **s, size_t n)
+{
+    return rq_insert_tail_n(q, s, n);
+}
+
+static bool ring_remove_head(void *q, char *sp, size_t bufsize)
+{
+    return rq_remove_head(q, sp, bufsize);
+}
+
+static bool ring_remove_tail(void *q, char *sp, size_t bufsize)
+{
+    return rq_remove_tail(q, sp, bufsize);
+}
+
+static size_t ring_remove_head_n(void *q, size_t n)
+{
+    size_t removed = 0;
+    while (removed < n && rq_remove_head(q, NULL, 0))
+        removed++;
+    return removed;
+}
+
+static size_t ring_size(void *q)
+{
+    return rq_size(q);
+}
+
+static bool ring_delete_mid(void *q)
+{
+    return rq_delete_mid(q);
+}
+
+static bool ring_delete_dup(void *q)
+{
+    return rq_delete_dup(q);
+}
+
+static void ring_swap(void *q)
+{
+    rq_swap(q);
+}
+
+static void ring_reverse(void *q)
+{
+    rq_reverse(q);
+}
+
+static void ring_sort(void *q)
+{
+    rq_sort(q);
+}
+
+/* Point it at logical position i, return false past either end */
+static bool ring_at(rqueue_t *q, size_t i, q_iter_t *it)
+{
+    it->slot = i;
+    if (i >= q->size)
+        return false;
+    it->value = rq_at(q, i);
+    it->len = strlen(it->value);
+    return true;
+}
+
+static bool ring_first(void *q, q_iter_t *it)
+{
+    return ring_at(q, 0, it);
+}
+
+static bool ring_last(void *q, q_iter_t *it)
+{
+    return ring_at(q, ((rqueue_t *) q)->size - 1, it);
+}
+
+static bool ring_next(void *q, q_iter_t *it)
+{
+    return ring_at(q, it->slot + 1, it);
+}
+
+static bool ring_prev(void *q, q_iter_t *it)
+{
+    return ring_at(q, it->slot - 1, it);
+}
+
+const queue_ops_t ring_ops = {
+    .name = "ring",
+    .new = ring_new,
+    .free = ring_free,
+    .insert_head = ring_insert_head,
+    .insert_tail = ring_insert_tail,
+    .insert_head_n = ring_insert_head_n,
+    .insert_tail_n = ring_insert_tail_n,
+    .remove_head = ring_remove_head,
+    .remove_tail = ring_remove_tail,
+    .remove_head_n = ring_remove_head_n,
+    .size = ring_size,
+    .delete_mid = ring_delete_mid,
+    .delete_dup = ring_delete_dup,
+    .swap = ring_swap,
+    .reverse = ring_reverse,
+    .sort = ring_sort,
+    .first = ring_first,
+    .last = ring_last,
+    .next = ring_next,
+    .prev = ring_prev,
+};
+
+static void *index_new()
+{
+    return iq_new();
+}
+
+static void index_free(void *q)
+{
+    iq_free(q);
+}
+
+static bool index_insert_head(void *q, char *s)
+{
+    return iq_insert_head(q, s);
+}
+
+static bool index_insert_tail(void *q, char *s)
+{
+    return iq_insert_tail(q, s);
+}
+
+static bool index_insert_head_n(void *q, char **s, size_t n)
+{
+    return iq_insert_head_n(q, s, n);
+}
+
+static bool index_insert_tail_n(void *q, char **s, size_t n)
+{
+    return iq_insert_tail_n(q, s, n);
+}
+
+static bool index_remove_head(void *q, char *sp, size_t bufsize)
+{
+    return iq_remove_head(q, sp, bufsize);
+}
+
+static bool index_remove_tail(void *q, char *sp, size_t bufsize)
+{
+    return iq_remove_tail(q, sp, bufsize);
+}
+
+static size_t index_remove_head_n(void *q, size_t n)
+{
+    size_t removed = 0;
+    while (removed < n && iq_remove_head(q, NULL, 0))
+        removed++;
+    return removed;
+}
+
+static size_t index_size(void *q)
+{
+    return iq_size(q);
+}
+
+static bool index_delete_mid(void *q)
+{
+    return iq_delete_mid(q);
+}
+
+static bool index_delete_dup(void *q)
+{
+    return iq_delete_dup(q);
+}
+
+static void index_swap(void *q)
+{
+    iq_swap(q);
+}
+
+static void index_reverse(void *q)
+{
+    iq_reverse(q);
+}
+
+static void index_sort(void *q)
+{
+    iq_sort(q);
+}
+
+/* Point it at node i of queue q, return false at the sentinel */
+static bool index_at(iqueue_t *q, uint32_t i, q_iter_t *it)
+{
+    it->slot = i;
+    if (i == q->head)
+        return false;
+    it->value = iq_value(q, i);
+    it->len = iq_node(q, i)->len;
+    return true;
+}
+
+static bool index_first(void *q, q_iter_t *it)
+{
+    iqueue_t *iq = q;
+    return index_at(iq, ilist_next(&iq->pool, iq->head), it);
+}
+
+static bool index_last(void *q, q_iter_t *it)
+{
+    iqueue_t *iq = q;
+    return index_at(iq, ilist_prev(&iq->pool, iq->head), it);
+}
+
+static bool index_next(void *q, q_iter_t *it)
+{
+    iqueue_t *iq = q;
+    return index_at(iq, ilist_next(&iq->pool, it->slot), it);
+}
+
+static bool index_prev(void *q, q_iter_t *it)
+{
+    iqueue_t *iq = q;
+    return index_at(iq, ilist_prev(&iq->pool, it->slot), it);
+}
+
+const queue_ops_t index_ops = {
+    .name = "index",
+    .new = index_new,
+    .free = index_free,
+    .insert_head = index_insert_head,
+    .insert_tail = index_insert_tail,
+    .insert_head_n = index_insert_head_n,
+    .insert_tail_n = index_insert_tail_n,
+    .remove_head = index_remove_head,
+    .remove_tail = index_remove_tail,
+    .remove_head_n = index_remove_head_n,
+    .size = index_size,
+    .delete_mid = index_delete_mid,
+    .delete_dup = index_delete_dup,
+    .swap = index_swap,
+    .reverse = index_reverse,
+    .sort = index_sort,
+    .first = index_first,
+    .last = index_last,
+    .next = index_next,
+    .prev = index_prev,
+};
+
+static const queue_ops_t *backends[] = {&list_ops, &unrolled_ops, &ring_ops,
+                                        &index_ops};
+
+const queue_ops_t *find_backend(const char *name)
+{
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (!strcmp(backends[i]->name, name))
+            return backends[i];
+    }
+    return NULL;
+}
@@ -0,0 +1,65 @@
+#ifndef LAB0_BACKEND_H
+#define LAB0_BACKEND_H
+
+/*
+ * Queue backends.
+ *
+ * qtest drives its queue through one of these tables, chosen at startup, so
+ * that the same traces can be run against different implementations.  The
+ * operations follow queue.h, except that removals copy the value out and
+ * release it in one step, since not every backend has an element_t to hand
+ * back.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Cursor over the values of a queue, filled in by first/last/next/prev */
+typedef struct {
+    void *pos;
+    size_t slot;
+    const char *value;
+    size_t len;
+} q_iter_t;
+
+typedef struct {
+    const char *name;
+    void *(*new)();
+    void (*free)(void *q);
+    bool (*insert_head)(void *q, char *s);
+    bool (*insert_tail)(void *q, char *s);
+    bool (*insert_head_n)(void *q, char **s, size_t n);
+    bool (*insert_tail_n)(void *q, char **s, size_t n);
+    bool (*remove_head)(void *q, char *sp, size_t bufsize);
+    bool (*remove_tail)(void *q, char *sp, size_t bufsize);
+    /* Remove up to n values from the head, return how many were removed */
+    size_t (*remove_head_n)(void *q, size_t n);
+    size_t (*size)(void *q);
+    bool (*delete_mid)(void *q);
+    bool (*delete_dup)(void *q);
+    void (*swap)(void *q);
+    void (*reverse)(void *q);
+    void (*sort)(void *q);
+    /* Position it at an end or move it along.  Return false past the end. */
+    bool (*first)(void *q, q_iter_t *it);
+    bool (*last)(void *q, q_iter_t *it);
+    bool (*next)(void *q, q_iter_t *it);
+    bool (*prev)(void *q, q_iter_t *it);
+} queue_ops_t;
+
+/* Doubly-linked list of element_t, as implemented in queue.c */
+extern const queue_ops_t list_ops;
+
+/* Unrolled linked list, see unrolled.h */
+extern const queue_ops_t unrolled_ops;
+
+/* Ring buffer deque, see ring.h */
+extern const queue_ops_t ring_ops;
+
+/* Compact index-linked queue, see iqueue.h */
+extern const queue_ops_t index_ops;
+
+/* Look a backend up by name.  Return NULL if there is no such backend. */
+const queue_ops_t *find_backend(const char *name);
+
+#endif /* LAB0_BACKEND_H */
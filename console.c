@@ -3,6 +3,7 @@
 #include "console.h"
 
 #include <ctype.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
@@ -291,6 +292,32 @@ bool get_int(char *vname, int *loc)
     return true;
 }
 
+bool get_long(char *vname, long *loc)
+{
+    char *end = NULL;
+    errno = 0;
+    long v = strtol(vname, &end, 0);
+    if (errno || *end != '\0' || end == vname)
+        return false;
+
+    *loc = v;
+    return true;
+}
+
+bool get_size(char *vname, size_t *loc)
+{
+    char *end = NULL;
+    errno = 0;
+    unsigned long long v = strtoull(vname, &end, 0);
+    /* strtoull quietly negates a leading minus sign */
+    if (errno || *end != '\0' || end == vname || strchr(vname, '-') ||
+        v > SIZE_MAX)
+        return false;
+
+    *loc = (size_t) v;
+    return true;
+}
+
 static bool do_option(int argc, char *argv[])
 {
     if (argc == 1) {
@@ -1,6 +1,7 @@
 #ifndef LAB0_CONSOLE_H
 #define LAB0_CONSOLE_H
 #include <stdbool.h>
+#include <stddef.h>
 #include <sys/select.h>
 #include "linenoise.h"
 #define HISTORY_FILE ".cmd_history"
@@ -54,6 +55,12 @@ void add_param(char *name,
 /* Extract integer from text and store at loc */
 bool get_int(char *vname, int *loc);
 
+/* Extract a long integer from text and store at loc */
+bool get_long(char *vname, long *loc);
+
+/* Extract a count, which may exceed INT_MAX, from text and store at loc */
+bool get_size(char *vname, size_t *loc);
+
 /* Add function to be executed as part of program exit */
 void add_quit_helper(cmd_function qf);
 
@@ -0,0 +1,222 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fcode.h"
+#include "harness.h"
+
+/* Bytes allocated by the first append */
+#define FC_MIN_CAPACITY 256
+
+/* Longest LEB128 encoding of a size_t */
+#define FC_VARINT_MAX 10
+
+fcode_t *fc_new()
+{
+    fcode_t *fc = malloc(sizeof(fcode_t));
+    if (!fc)
+        return NULL;
+    fc->data = NULL;
+    fc->len = fc->cap = 0;
+    fc->restarts = NULL;
+    fc->nrestarts = fc->restarts_cap = 0;
+    fc->count = 0;
+    fc_cursor_init(&fc->head);
+    fc_cursor_init(&fc->tail);
+    return fc;
+}
+
+void fc_free(fcode_t *fc)
+{
+    if (!fc)
+        return;
+    free(fc->data);
+    free(fc->restarts);
+    fc_cursor_free(&fc->head);
+    fc_cursor_free(&fc->tail);
+    free(fc);
+}
+
+void fc_cursor_init(struct fc_cursor *c)
+{
+    c->index = c->off = 0;
+    c->str = NULL;
+    c->len = c->cap = 0;
+}
+
+void fc_cursor_free(struct fc_cursor *c)
+{
+    free(c->str);
+    fc_cursor_init(c);
+}
+
+/*
+ * Make room for size bytes in the array *p of *cap bytes, of which the first
+ * keep are in use, doubling it as needed.  Return false if out of space.
+ */
+static bool fc_reserve(void *p, size_t *cap, size_t keep, size_t size)
+{
+    if (size <= *cap)
+        return true;
+    size_t n = *cap ? *cap : FC_MIN_CAPACITY;
+    while (n < size)
+        n *= 2;
+    char *buf = malloc(n);
+    if (!buf)
+        return false;
+    char **old = p;
+    if (keep)
+        memcpy(buf, *old, keep);
+    free(*old);
+    *old = buf;
+    *cap = n;
+    return true;
+}
+
+static size_t fc_put_varint(char *dst, size_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        dst[n++] = (char) (v | 0x80);
+        v >>= 7;
+    }
+    dst[n++] = (char) v;
+    return n;
+}
+
+static size_t fc_get_varint(const char *src, size_t *v)
+{
+    size_t n = 0, shift = 0;
+    *v = 0;
+    uint8_t b;
+    do {
+        b = src[n++];
+        *v |= (size_t) (b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    return n;
+}
+
+bool fc_append(fcode_t *fc, const char *s, size_t len)
+{
+    struct fc_cursor *t = &fc->tail;
+    bool restart = !(fc->count % FC_RESTART);
+    size_t shared = 0;
+    if (!restart) {
+        while (shared < len && shared < t->len && s[shared] == t->str[shared])
+            shared++;
+    }
+
+    /* Claim all the space first, so that a failure changes nothing */
+    size_t entry = 2 * FC_VARINT_MAX + len - shared;
+    if (!fc_reserve(&fc->data, &fc->cap, fc->len, fc->len + entry) ||
+        !fc_reserve(&t->str, &t->cap, shared, len + 1))
+        return false;
+    if (restart &&
+        !fc_reserve(&fc->restarts, &fc->restarts_cap,
+                    fc->nrestarts * sizeof(size_t),
+                    (fc->nrestarts + 1) * sizeof(size_t)))
+        return false;
+
+    if (restart)
+        fc->restarts[fc->nrestarts++] = fc->len;
+    fc->len += fc_put_varint(fc->data + fc->len, shared);
+    fc->len += fc_put_varint(fc->data + fc->len, len - shared);
+    memcpy(fc->data + fc->len, s + shared, len - shared);
+    fc->len += len - shared;
+
+    memcpy(t->str + shared, s + shared, len - shared);
+    t->str[len] = '\0';
+    t->len = len;
+    t->index = ++fc->count;
+    t->off = fc->len;
+    return true;
+}
+
+bool fc_trim(fcode_t *fc)
+{
+    if (!fc->len || fc->len == fc->cap)
+        return true;
+    char *data = malloc(fc->len);
+    if (!data)
+        return false;
+    memcpy(data, fc->data, fc->len);
+    free(fc->data);
+    fc->data = data;
+    fc->cap = fc->len;
+    return true;
+}
+
+size_t fc_size(fcode_t *fc)
+{
+    return fc ? fc->count - fc->head.index : 0;
+}
+
+size_t fc_bytes(fcode_t *fc)
+{
+    if (!fc)
+        return 0;
+    return sizeof(fcode_t) + fc->cap + fc->restarts_cap + fc->head.cap +
+           fc->tail.cap;
+}
+
+bool fc_next(fcode_t *fc, struct fc_cursor *c)
+{
+    if (c->index == fc->count)
+        return false;
+
+    size_t shared, rest;
+    size_t off = c->off;
+    off += fc_get_varint(fc->data + off, &shared);
+    off += fc_get_varint(fc->data + off, &rest);
+    if (!fc_reserve(&c->str, &c->cap, shared, shared + rest + 1))
+        return false;
+
+    memcpy(c->str + shared, fc->data + off, rest);
+    c->len = shared + rest;
+    c->str[c->len] = '\0';
+    c->off = off + rest;
+    c->index++;
+    return true;
+}
+
+bool fc_seek(fcode_t *fc, size_t i, struct fc_cursor *c)
+{
+    if (i >= fc_size(fc))
+        return false;
+    size_t target = fc->head.index + i;
+
+    /* Carry on from the head if no restart point lies between */
+    size_t r = target / FC_RESTART;
+    if (r * FC_RESTART <= fc->head.index) {
+        if (!fc_reserve(&c->str, &c->cap, 0, fc->head.len + 1))
+            return false;
+        if (fc->head.len)
+            memcpy(c->str, fc->head.str, fc->head.len);
+        c->len = fc->head.len;
+        c->index = fc->head.index;
+        c->off = fc->head.off;
+    } else {
+        c->index = r * FC_RESTART;
+        c->off = fc->restarts[r];
+        c->len = 0;
+    }
+
+    while (c->index <= target) {
+        if (!fc_next(fc, c))
+            return false;
+    }
+    return true;
+}
+
+bool fc_remove_head(fcode_t *fc, char *sp, size_t bufsize)
+{
+    if (!fc || !fc_next(fc, &fc->head))
+        return false;
+    if (sp && bufsize) {
+        size_t n = fc->head.len < bufsize - 1 ? fc->head.len : bufsize - 1;
+        memcpy(sp, fc->head.str, n);
+        sp[n] = '\0';
+    }
+    return true;
+}
@@ -0,0 +1,106 @@
+#ifndef LAB0_FCODE_H
+#define LAB0_FCODE_H
+
+/*
+ * Front-coded string store.
+ *
+ * Strings are appended in order to one byte buffer, each as the length of
+ * the prefix it shares with the string before it, the length of the rest,
+ * and the rest itself, with both lengths as LEB128 varints.  A sorted run of
+ * strings with long common prefixes thus shrinks to little more than the
+ * tails that tell them apart.
+ *
+ * Every FC_RESTART strings the shared prefix is dropped and the offset of
+ * the entry recorded, so that fc_seek can start decoding there rather than
+ * at the front.
+ *
+ * Decoding needs the string before the entry, which a struct fc_cursor
+ * carries along, so scans run forward.  Removal from the head keeps such a
+ * cursor in the store; the bytes of removed strings stay until fc_free.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Strings between restart points */
+#define FC_RESTART 16
+
+/* Position in a store, holding the string decoded last */
+struct fc_cursor {
+    /* Number of strings decoded so far, counting from the front */
+    size_t index;
+    /* Offset of the next entry */
+    size_t off;
+    /* The string decoded last, null-terminated, of len characters */
+    char *str;
+    size_t len, cap;
+};
+
+typedef struct {
+    char *data;
+    size_t len, cap;
+    /* Offset of every FC_RESTART-th entry */
+    size_t *restarts;
+    size_t nrestarts, restarts_cap;
+    /* Number of strings appended */
+    size_t count;
+    /* Just past the last string removed */
+    struct fc_cursor head;
+    /* Just past the last string appended */
+    struct fc_cursor tail;
+} fcode_t;
+
+/* Create an empty store.  Return NULL if could not allocate space. */
+fcode_t *fc_new();
+
+/* Free all storage used by store, no effect if fc is NULL */
+void fc_free(fcode_t *fc);
+
+/*
+ * Append a copy of s, of len characters, after the last string.
+ * Return false if could not allocate space, in which case the store is
+ * left unchanged.
+ */
+bool fc_append(fcode_t *fc, const char *s, size_t len);
+
+/*
+ * Give back the room reserved for further appends.
+ * Return false if the smaller buffer could not be allocated, in which case
+ * the store keeps the larger one.
+ */
+bool fc_trim(fcode_t *fc);
+
+/* Return number of strings in store not yet removed, 0 if fc is NULL */
+size_t fc_size(fcode_t *fc);
+
+/* Return bytes allocated for store, 0 if fc is NULL */
+size_t fc_bytes(fcode_t *fc);
+
+/* Prepare an empty cursor, which allocates nothing */
+void fc_cursor_init(struct fc_cursor *c);
+
+/* Release the string held by cursor */
+void fc_cursor_free(struct fc_cursor *c);
+
+/*
+ * Decode the string at c into c->str and move past it.
+ * Return false at the end of the store, or if could not allocate space.
+ */
+bool fc_next(fcode_t *fc, struct fc_cursor *c);
+
+/*
+ * Decode the i-th string not yet removed, counting from 0, into c->str,
+ * starting from the nearest restart point before it.  fc_next then carries
+ * on from there.
+ * Return false if there is no such string or could not allocate space.
+ */
+bool fc_seek(fcode_t *fc, size_t i, struct fc_cursor *c);
+
+/*
+ * Remove the string at head, decoding it on the way.  If sp is non-NULL,
+ * copy it to *sp, at most bufsize - 1 characters plus a null terminator.
+ * Return false if fc is NULL or empty, or if could not allocate space.
+ */
+bool fc_remove_head(fcode_t *fc, char *sp, size_t bufsize);
+
+#endif /* LAB0_FCODE_H */
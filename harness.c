@@ -1,5 +1,6 @@
 /* Test support code */
 
+#include <pthread.h>
 #include <setjmp.h>
 #include <signal.h>
 #include <stdio.h>
@@ -7,6 +8,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "reclaim.h"
 #include "report.h"
 
 /* Our program needs to use regular malloc/free */
@@ -43,12 +45,14 @@ typedef struct BELE {
 
 static block_ele_t *allocated = NULL;
 static size_t allocated_count = 0;
+static size_t allocated_bytes = 0;
 
 /* Percent probability of malloc failure */
 int fail_probability = 0;
 
-static bool cautious_mode = true;
-static bool noallocate_mode = false;
+/* Per thread, so that other threads do not trip over the main one's */
+static __thread bool cautious_mode = true;
+static __thread bool noallocate_mode = false;
 static bool error_occurred = false;
 static char *error_message = "";
 
@@ -61,10 +65,35 @@ static jmp_buf env;
 static volatile sig_atomic_t jmp_ready = false;
 static bool time_limited = false;
 
+/*
+ * Once threaded, the block list and counters above are guarded by
+ * harness_lock.  holding tells the main thread whether a longjmp left it
+ * holding the lock.
+ */
+static bool threaded = false;
+static pthread_mutex_t harness_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread bool holding = false;
+
 /*
  * Internal functions
  */
 
+static void lock_harness()
+{
+    if (!threaded)
+        return;
+    pthread_mutex_lock(&harness_lock);
+    holding = true;
+}
+
+static void unlock_harness()
+{
+    if (!holding)
+        return;
+    holding = false;
+    pthread_mutex_unlock(&harness_lock);
+}
+
 /* Should this allocation fail? */
 static bool fail_allocation()
 {
@@ -134,6 +163,7 @@ void *test_malloc(size_t size)
         return NULL;
     }
 
+    lock_harness();
     block_ele_t *new_block =
         malloc(size + sizeof(block_ele_t) + sizeof(size_t));
     if (!new_block) {
@@ -157,6 +187,8 @@ void *test_malloc(size_t size)
         allocated->prev = new_block;
     allocated = new_block;
     allocated_count++;
+    allocated_bytes += size;
+    unlock_harness();
 
     return p;
 }
@@ -183,6 +215,7 @@ void test_free(void *p)
     if (!p)
         return;
 
+    lock_harness();
     block_ele_t *b = find_header(p);
     size_t footer = *find_footer(b);
     if (footer != MAGICFOOTER) {
@@ -206,8 +239,10 @@ void test_free(void *p)
     if (bn)
         bn->prev = bp;
 
+    allocated_bytes -= b->payload_size;
     free(b);
     allocated_count--;
+    unlock_harness();
 }
 
 // cppcheck-suppress unusedFunction
@@ -223,7 +258,23 @@ char *test_strdup(const char *s)
 
 size_t allocation_check()
 {
-    return allocated_count;
+    lock_harness();
+    size_t count = allocated_count;
+    unlock_harness();
+    return count;
+}
+
+size_t allocation_bytes()
+{
+    lock_harness();
+    size_t bytes = allocated_bytes;
+    unlock_harness();
+    return bytes;
+}
+
+void set_threaded_mode()
+{
+    threaded = true;
 }
 
 /*
@@ -253,8 +304,10 @@ void set_noallocate_mode(bool noallocate)
  */
 bool error_check()
 {
+    lock_harness();
     bool e = error_occurred;
     error_occurred = false;
+    unlock_harness();
     return e;
 }
 
@@ -266,6 +319,8 @@ bool exception_setup(bool limit_time)
 {
     if (sigsetjmp(env, 1)) {
         /* Got here from longjmp */
+        unlock_harness();
+        reclaim_unlock();
         jmp_ready = false;
         if (time_limited) {
             alarm(0);
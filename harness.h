@@ -17,11 +17,21 @@ void test_free(void *p);
 char *test_strdup(const char *s);
 /* FIXME: provide test_realloc as well */
 
+/*
+ * Make the functions above safe to call from more than one thread.  Must be
+ * called before a second thread starts using them, and cannot be undone.
+ * Cautious and restricted allocation modes are then set per thread.
+ */
+void set_threaded_mode();
+
 #ifdef INTERNAL
 
 /* Report number of allocated blocks */
 size_t allocation_check();
 
+/* Report number of bytes requested by the blocks still allocated */
+size_t allocation_bytes();
+
 /* Probability of malloc failing, expressed as percent */
 extern int fail_probability;
 
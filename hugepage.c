@@ -0,0 +1,70 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "hugepage.h"
+
+/* Updated from the reclaimer as well, which frees regions of freed queues */
+static atomic_size_t regions, bytes;
+
+/* Whether the kernel may hand out huge pages for madvised regions */
+static bool huge_supported()
+{
+    static int supported = -1;
+    if (supported >= 0)
+        return supported;
+    char mode[64] = "";
+    FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (f) {
+        if (!fgets(mode, sizeof(mode), f))
+            mode[0] = '\0';
+        fclose(f);
+    }
+    supported = mode[0] && !strstr(mode, "[never]");
+    return supported;
+}
+
+void *huge_alloc(size_t size)
+{
+    if (!huge_supported())
+        return NULL;
+    size = huge_round(size);
+    /* Map a page more than needed, so that an aligned run fits */
+    char *raw = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+        return NULL;
+    char *p = (char *) (((uintptr_t) raw + HUGE_PAGE_SIZE - 1) &
+                        ~((uintptr_t) HUGE_PAGE_SIZE - 1));
+    if (p > raw)
+        munmap(raw, p - raw);
+    munmap(p + size, raw + HUGE_PAGE_SIZE - p);
+#ifdef MADV_HUGEPAGE
+    /* If this fails, the region still works on small pages */
+    madvise(p, size, MADV_HUGEPAGE);
+#endif
+    regions++;
+    bytes += size;
+    return p;
+}
+
+void huge_free(void *p, size_t size)
+{
+    size = huge_round(size);
+    munmap(p, size);
+    regions--;
+    bytes -= size;
+}
+
+size_t huge_regions()
+{
+    return regions;
+}
+
+size_t huge_bytes()
+{
+    return bytes;
+}
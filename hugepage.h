@@ -0,0 +1,40 @@
+#ifndef LAB0_HUGEPAGE_H
+#define LAB0_HUGEPAGE_H
+
+/*
+ * Regions backed by transparent huge pages.
+ *
+ * Regions are mapped directly, aligned to HUGE_PAGE_SIZE and marked with
+ * MADV_HUGEPAGE before they are first touched, so that the kernel can back
+ * them with 2 MiB pages and a walk over millions of nodes needs a fraction
+ * of the TLB entries.  Where transparent huge pages are disabled, huge_alloc
+ * gives up at once and callers fall back to malloc.
+ *
+ * The test harness does not see these regions, so they are counted here
+ * instead, for the leak checks of qtest.
+ */
+
+#include <stddef.h>
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+static inline size_t huge_round(size_t size)
+{
+    return (size + HUGE_PAGE_SIZE - 1) & ~((size_t) HUGE_PAGE_SIZE - 1);
+}
+
+/*
+ * Return a zeroed region of huge_round(size) bytes aligned to
+ * HUGE_PAGE_SIZE, or NULL if huge pages are disabled or the region could
+ * not be mapped.
+ */
+void *huge_alloc(size_t size);
+
+/* Unmap a region obtained from huge_alloc with the same size */
+void huge_free(void *p, size_t size);
+
+/* Number of regions mapped and not yet freed, and their bytes */
+size_t huge_regions();
+size_t huge_bytes();
+
+#endif /* LAB0_HUGEPAGE_H */
@@ -0,0 +1,68 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "ilist.h"
+
+void ipool_init(struct ipool *p, size_t node_size)
+{
+    p->chunks = NULL;
+    p->nchunks = p->max_chunks = 0;
+    p->node_size = node_size;
+    p->fresh = 0;
+    p->free = IPOOL_NIL;
+    p->live = 0;
+}
+
+/* Add a chunk of fresh nodes, doubling the chunk table when it is full */
+static bool ipool_grow(struct ipool *p)
+{
+    if ((uint64_t) (p->nchunks + 1) << IPOOL_CHUNK_SHIFT > IPOOL_NIL)
+        return false;
+    if (p->nchunks == p->max_chunks) {
+        uint32_t max = p->max_chunks ? 2 * p->max_chunks : 8;
+        char **chunks = malloc(max * sizeof(char *));
+        if (!chunks)
+            return false;
+        if (p->nchunks)
+            memcpy(chunks, p->chunks, p->nchunks * sizeof(char *));
+        free(p->chunks);
+        p->chunks = chunks;
+        p->max_chunks = max;
+    }
+    char *chunk = malloc(p->node_size << IPOOL_CHUNK_SHIFT);
+    if (!chunk)
+        return false;
+    p->chunks[p->nchunks++] = chunk;
+    return true;
+}
+
+uint32_t ipool_alloc(struct ipool *p)
+{
+    uint32_t i = p->free;
+    if (i != IPOOL_NIL) {
+        p->free = ipool_at(p, i)->next;
+    } else {
+        if (p->fresh == (uint64_t) p->nchunks << IPOOL_CHUNK_SHIFT &&
+            !ipool_grow(p))
+            return IPOOL_NIL;
+        i = p->fresh++;
+    }
+    p->live++;
+    return i;
+}
+
+void ipool_free(struct ipool *p, uint32_t i)
+{
+    ipool_at(p, i)->next = p->free;
+    p->free = i;
+    p->live--;
+}
+
+void ipool_destroy(struct ipool *p)
+{
+    for (uint32_t c = 0; c < p->nchunks; c++)
+        free(p->chunks[c]);
+    free(p->chunks);
+    ipool_init(p, p->node_size);
+}
@@ -0,0 +1,135 @@
+#ifndef LAB0_ILIST_H
+#define LAB0_ILIST_H
+
+/*
+ * Index-linked circular doubly-linked lists.
+ *
+ * The same shape as list.h, except that nodes name each other by 32-bit
+ * index into a struct ipool instead of by pointer, which halves the cost of
+ * the links.  Every operation takes the pool the indices refer to.  Nodes
+ * are kept in fixed-size chunks, so growing the pool never moves a node.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Index that names no node */
+#define IPOOL_NIL UINT32_MAX
+
+/* Each chunk holds 1 << IPOOL_CHUNK_SHIFT nodes */
+#define IPOOL_CHUNK_SHIFT 14
+#define IPOOL_CHUNK_NODES (1u << IPOOL_CHUNK_SHIFT)
+
+/* Must be the first member of every node */
+struct ilist_head {
+    uint32_t next, prev;
+};
+
+struct ipool {
+    char **chunks;
+    uint32_t nchunks, max_chunks;
+    size_t node_size;
+    /* Next never used index, and first index on the free list */
+    uint32_t fresh, free;
+    /* Number of nodes handed out and not yet released */
+    size_t live;
+};
+
+/* Prepare an empty pool of node_size-byte nodes.  Allocates nothing. */
+void ipool_init(struct ipool *p, size_t node_size);
+
+/* Return the index of a node, or IPOOL_NIL if no space could be allocated */
+uint32_t ipool_alloc(struct ipool *p);
+
+/* Give back a node obtained from ipool_alloc */
+void ipool_free(struct ipool *p, uint32_t i);
+
+/* Release every chunk at once.  The pool is left empty. */
+void ipool_destroy(struct ipool *p);
+
+static inline struct ilist_head *ipool_at(const struct ipool *p, uint32_t i)
+{
+    return (struct ilist_head *) (p->chunks[i >> IPOOL_CHUNK_SHIFT] +
+                                  (i & (IPOOL_CHUNK_NODES - 1)) *
+                                      p->node_size);
+}
+
+/* Get the node of the given type that index i refers to */
+#define ilist_entry(p, i, type) ((type *) ipool_at(p, i))
+
+static inline void INIT_ILIST_HEAD(struct ipool *p, uint32_t head)
+{
+    ipool_at(p, head)->next = head;
+    ipool_at(p, head)->prev = head;
+}
+
+/* Link node between the adjacent nodes prev and next */
+static inline void __ilist_add(struct ipool *p,
+                               uint32_t node,
+                               uint32_t prev,
+                               uint32_t next)
+{
+    struct ilist_head *n = ipool_at(p, node);
+    n->prev = prev;
+    n->next = next;
+    ipool_at(p, prev)->next = node;
+    ipool_at(p, next)->prev = node;
+}
+
+/* Insert node after head, as list_add */
+static inline void ilist_add(struct ipool *p, uint32_t node, uint32_t head)
+{
+    __ilist_add(p, node, head, ipool_at(p, head)->next);
+}
+
+/* Insert node before head, as list_add_tail */
+static inline void ilist_add_tail(struct ipool *p,
+                                  uint32_t node,
+                                  uint32_t head)
+{
+    __ilist_add(p, node, ipool_at(p, head)->prev, head);
+}
+
+/* Unlink node from its list, as list_del */
+static inline void ilist_del(struct ipool *p, uint32_t node)
+{
+    struct ilist_head *n = ipool_at(p, node);
+    ipool_at(p, n->prev)->next = n->next;
+    ipool_at(p, n->next)->prev = n->prev;
+}
+
+/* Unlink node and make it an empty list of its own, as list_del_init */
+static inline void ilist_del_init(struct ipool *p, uint32_t node)
+{
+    ilist_del(p, node);
+    INIT_ILIST_HEAD(p, node);
+}
+
+static inline bool ilist_empty(const struct ipool *p, uint32_t head)
+{
+    return ipool_at(p, head)->next == head;
+}
+
+static inline bool ilist_is_singular(const struct ipool *p, uint32_t head)
+{
+    struct ilist_head *h = ipool_at(p, head);
+    return h->next != head && h->prev == h->next;
+}
+
+static inline uint32_t ilist_next(const struct ipool *p, uint32_t node)
+{
+    return ipool_at(p, node)->next;
+}
+
+static inline uint32_t ilist_prev(const struct ipool *p, uint32_t node)
+{
+    return ipool_at(p, node)->prev;
+}
+
+/* Iterate over the indices of the nodes of a list, as list_for_each */
+#define ilist_for_each(p, node, head)                \
+    for (node = ilist_next(p, head); node != (head); \
+         node = ilist_next(p, node))
+
+#endif /* LAB0_ILIST_H */
@@ -0,0 +1,139 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "intern.h"
+
+#define INTERN_MIN_BUCKETS 64
+
+struct intern_entry {
+    struct intern_entry *next;
+    size_t refs;
+    uint32_t hash;
+    uint32_t len;
+    char str[];
+};
+
+static inline struct intern_entry *intern_entry_of(char *s)
+{
+    return (struct intern_entry *) (s - offsetof(struct intern_entry, str));
+}
+
+static inline size_t intern_size(size_t len)
+{
+    return offsetof(struct intern_entry, str) + len + 1;
+}
+
+uint32_t intern_hash(const char *s, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char) s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void intern_init(struct intern *t, struct arena *strs)
+{
+    t->buckets = NULL;
+    t->mask = 0;
+    t->count = 0;
+    t->strs = strs;
+}
+
+/*
+ * Double the number of buckets, or create the first ones.  On failure the
+ * table keeps its buckets, which only makes the chains longer.
+ */
+static void intern_grow(struct intern *t)
+{
+    size_t n = t->buckets ? 2 * (t->mask + 1) : INTERN_MIN_BUCKETS;
+    struct intern_entry **buckets = malloc(n * sizeof(*buckets));
+    if (!buckets)
+        return;
+    memset(buckets, 0, n * sizeof(*buckets));
+    for (size_t i = 0; t->buckets && i <= t->mask; i++) {
+        struct intern_entry *e = t->buckets[i], *next;
+        for (; e; e = next) {
+            next = e->next;
+            e->next = buckets[e->hash & (n - 1)];
+            buckets[e->hash & (n - 1)] = e;
+        }
+    }
+    free(t->buckets);
+    t->buckets = buckets;
+    t->mask = n - 1;
+}
+
+char *intern_get(struct intern *t, const char *s, size_t len)
+{
+    if (len >= UINT32_MAX)
+        return NULL;
+    if (!t->buckets || t->count > t->mask) {
+        intern_grow(t);
+        if (!t->buckets)
+            return NULL;
+    }
+    uint32_t hash = intern_hash(s, len);
+    struct intern_entry **bucket = &t->buckets[hash & t->mask];
+    for (struct intern_entry *e = *bucket; e; e = e->next) {
+        if (e->hash == hash && e->len == len && !memcmp(e->str, s, len)) {
+            e->refs++;
+            return e->str;
+        }
+    }
+
+    size_t size = intern_size(len);
+    struct intern_entry *e = size <= ARENA_MAX_ALLOC
+                                 ? arena_alloc(t->strs, size)
+                                 : malloc(size);
+    if (!e)
+        return NULL;
+    e->refs = 1;
+    e->hash = hash;
+    e->len = len;
+    memcpy(e->str, s, len);
+    e->str[len] = '\0';
+    e->next = *bucket;
+    *bucket = e;
+    t->count++;
+    return e->str;
+}
+
+void intern_hold(char *s)
+{
+    intern_entry_of(s)->refs++;
+}
+
+void intern_put(struct intern *t, char *s)
+{
+    struct intern_entry *e = intern_entry_of(s);
+    if (--e->refs)
+        return;
+    struct intern_entry **p = &t->buckets[e->hash & t->mask];
+    while (*p != e)
+        p = &(*p)->next;
+    *p = e->next;
+    t->count--;
+
+    size_t size = intern_size(e->len);
+    if (size <= ARENA_MAX_ALLOC)
+        arena_free(t->strs, e, size);
+    else
+        free(e);
+}
+
+void intern_destroy(struct intern *t)
+{
+    for (size_t i = 0; t->buckets && i <= t->mask; i++) {
+        struct intern_entry *e = t->buckets[i], *next;
+        for (; e; e = next) {
+            next = e->next;
+            if (intern_size(e->len) > ARENA_MAX_ALLOC)
+                free(e);
+        }
+    }
+    free(t->buckets);
+    intern_init(t, t->strs);
+}
@@ -0,0 +1,53 @@
+#ifndef LAB0_INTERN_H
+#define LAB0_INTERN_H
+
+/*
+ * Table of reference-counted unique strings.
+ *
+ * intern_get hands out the one shared copy of a string, so all holders of
+ * equal strings from the same table hold the same pointer.  The copy stays
+ * alive until every reference has been dropped with intern_put.  Copies are
+ * carved from the arena given to intern_init when they fit in it.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+struct intern_entry;
+
+struct intern {
+    struct intern_entry **buckets;
+    /* Number of buckets minus one, the bucket count is a power of two */
+    size_t mask;
+    /* Number of distinct strings held */
+    size_t count;
+    struct arena *strs;
+};
+
+/* 32-bit FNV-1a hash of the len characters at s, as the table uses */
+uint32_t intern_hash(const char *s, size_t len);
+
+/* Prepare an empty table drawing on strs.  Allocates nothing. */
+void intern_init(struct intern *t, struct arena *strs);
+
+/*
+ * Return the shared copy of the len characters at s, creating it if needed,
+ * and take a reference to it.  Return NULL if could not allocate space.
+ */
+char *intern_get(struct intern *t, const char *s, size_t len);
+
+/* Take one more reference to a copy returned by intern_get */
+void intern_hold(char *s);
+
+/* Drop a reference taken by intern_get, the copy goes with the last one */
+void intern_put(struct intern *t, char *s);
+
+/*
+ * Free the table and every copy not carved from the arena, whether still
+ * referenced or not.  Copies in the arena go when the arena is destroyed.
+ */
+void intern_destroy(struct intern *t);
+
+#endif /* LAB0_INTERN_H */
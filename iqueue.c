@@ -0,0 +1,341 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "iqueue.h"
+
+iqueue_t *iq_new()
+{
+    iqueue_t *q = malloc(sizeof(iqueue_t));
+    if (!q)
+        return NULL;
+    ipool_init(&q->pool, sizeof(struct iq_node));
+    arena_init(&q->strs);
+    q->size = 0;
+    q->head = ipool_alloc(&q->pool);
+    if (q->head == IPOOL_NIL) {
+        ipool_destroy(&q->pool);
+        free(q);
+        return NULL;
+    }
+    INIT_ILIST_HEAD(&q->pool, q->head);
+    q->mid = q->head;
+    q->mid_valid = true;
+    return q;
+}
+
+/* Whether a string of len characters is kept in the arena */
+static inline bool iq_arena_value(size_t len)
+{
+    return len >= IQ_INLINE_LEN && len + 1 <= ARENA_MAX_ALLOC;
+}
+
+void iq_free(iqueue_t *q)
+{
+    if (!q)
+        return;
+    /* Only strings too long for the arena were allocated one by one */
+    uint32_t i;
+    ilist_for_each (&q->pool, i, q->head) {
+        size_t len = iq_node(q, i)->len;
+        if (len >= IQ_INLINE_LEN && !iq_arena_value(len))
+            free(iq_value(q, i));
+    }
+    ipool_destroy(&q->pool);
+    arena_destroy(&q->strs);
+    free(q);
+}
+
+/* Store a copy of s in node n, return false if it could not be allocated */
+static bool iq_set_value(iqueue_t *q, struct iq_node *n, const char *s)
+{
+    size_t len = strlen(s);
+    if (len >= UINT32_MAX)
+        return false;
+    n->len = len;
+    if (len < IQ_INLINE_LEN) {
+        memcpy(n->str, s, len + 1);
+        return true;
+    }
+    char *v =
+        iq_arena_value(len) ? arena_alloc(&q->strs, len + 1) : malloc(len + 1);
+    if (!v)
+        return false;
+    memcpy(v, s, len + 1);
+    memcpy(n->str, &v, sizeof(v));
+    return true;
+}
+
+/* Release the string of unlinked node i, then the node itself */
+static void iq_release(iqueue_t *q, uint32_t i)
+{
+    size_t len = iq_node(q, i)->len;
+    if (iq_arena_value(len))
+        arena_free(&q->strs, iq_value(q, i), len + 1);
+    else if (len >= IQ_INLINE_LEN)
+        free(iq_value(q, i));
+    ipool_free(&q->pool, i);
+}
+
+static void iq_mid_move(iqueue_t *q, long delta)
+{
+    for (; delta > 0; delta--)
+        q->mid = ilist_next(&q->pool, q->mid);
+    for (; delta < 0; delta++)
+        q->mid = ilist_prev(&q->pool, q->mid);
+}
+
+/* Bookkeeping after a node was linked in at one end */
+static void iq_added(iqueue_t *q, bool at_head)
+{
+    size_t n = q->size++;
+    if (!q->mid_valid)
+        return;
+    if (!n) {
+        q->mid = ilist_next(&q->pool, q->head);
+        return;
+    }
+    /* Positions in the new list */
+    long cur = at_head ? n / 2 + 1 : n / 2;
+    iq_mid_move(q, (long) ((n + 1) / 2) - cur);
+}
+
+/* Bookkeeping before a node is unlinked from one end */
+static void iq_removing(iqueue_t *q, bool at_head)
+{
+    size_t n = q->size--;
+    if (!q->mid_valid)
+        return;
+    if (n == 1) {
+        q->mid = q->head;
+        return;
+    }
+    /* Positions in the old list, the target is never the node removed */
+    long target = at_head ? 1 + (n - 1) / 2 : (n - 1) / 2;
+    iq_mid_move(q, target - (long) (n / 2));
+}
+
+static bool iq_insert(iqueue_t *q, char *s, bool at_head)
+{
+    if (!q || !s)
+        return false;
+    uint32_t i = ipool_alloc(&q->pool);
+    if (i == IPOOL_NIL)
+        return false;
+    if (!iq_set_value(q, iq_node(q, i), s)) {
+        ipool_free(&q->pool, i);
+        return false;
+    }
+    if (at_head)
+        ilist_add(&q->pool, i, q->head);
+    else
+        ilist_add_tail(&q->pool, i, q->head);
+    iq_added(q, at_head);
+    return true;
+}
+
+bool iq_insert_head(iqueue_t *q, char *s)
+{
+    return iq_insert(q, s, true);
+}
+
+bool iq_insert_tail(iqueue_t *q, char *s)
+{
+    return iq_insert(q, s, false);
+}
+
+bool iq_insert_head_n(iqueue_t *q, char **s, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (!iq_insert_head(q, s[i])) {
+            while (i--)
+                iq_remove_head(q, NULL, 0);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool iq_insert_tail_n(iqueue_t *q, char **s, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (!iq_insert_tail(q, s[i])) {
+            while (i--)
+                iq_remove_tail(q, NULL, 0);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool iq_remove(iqueue_t *q, char *sp, size_t bufsize, bool at_head)
+{
+    if (!q || ilist_empty(&q->pool, q->head))
+        return false;
+    uint32_t i = at_head ? ilist_next(&q->pool, q->head)
+                         : ilist_prev(&q->pool, q->head);
+    iq_removing(q, at_head);
+    ilist_del(&q->pool, i);
+    if (sp) {
+        size_t len = iq_node(q, i)->len;
+        len = len > bufsize - 1 ? bufsize - 1 : len;
+        memcpy(sp, iq_value(q, i), len);
+        sp[len] = '\0';
+    }
+    iq_release(q, i);
+    return true;
+}
+
+bool iq_remove_head(iqueue_t *q, char *sp, size_t bufsize)
+{
+    return iq_remove(q, sp, bufsize, true);
+}
+
+bool iq_remove_tail(iqueue_t *q, char *sp, size_t bufsize)
+{
+    return iq_remove(q, sp, bufsize, false);
+}
+
+size_t iq_size(iqueue_t *q)
+{
+    return q ? q->size : 0;
+}
+
+/* Unlink and release node i */
+static void iq_delete(iqueue_t *q, uint32_t i)
+{
+    ilist_del(&q->pool, i);
+    iq_release(q, i);
+    q->size--;
+}
+
+bool iq_delete_mid(iqueue_t *q)
+{
+    if (!q || ilist_empty(&q->pool, q->head))
+        return false;
+    size_t n = q->size;
+    if (!q->mid_valid) {
+        q->mid = ilist_next(&q->pool, q->head);
+        for (size_t i = n / 2; i; i--)
+            q->mid = ilist_next(&q->pool, q->mid);
+        q->mid_valid = true;
+    }
+    uint32_t mid = q->mid;
+    /* Node n / 2 of the shorter list is a neighbour of the deleted */
+    q->mid = n == 1    ? q->head
+             : (n & 1) ? ilist_next(&q->pool, mid)
+                       : ilist_prev(&q->pool, mid);
+    iq_delete(q, mid);
+    return true;
+}
+
+/* Compare the strings of nodes a and b as strcmp does */
+static int iq_cmp(const iqueue_t *q, uint32_t a, uint32_t b)
+{
+    size_t la = iq_node(q, a)->len, lb = iq_node(q, b)->len;
+    int c = memcmp(iq_value(q, a), iq_value(q, b), la < lb ? la : lb);
+    if (c)
+        return c;
+    return la < lb ? -1 : la > lb;
+}
+
+bool iq_delete_dup(iqueue_t *q)
+{
+    if (!q || ilist_empty(&q->pool, q->head))
+        return false;
+    q->mid_valid = false;
+    uint32_t front = ilist_next(&q->pool, q->head);
+    while (front != q->head) {
+        uint32_t back = ilist_next(&q->pool, front);
+        bool dup = false;
+        while (back != q->head && !iq_cmp(q, front, back)) {
+            uint32_t next = ilist_next(&q->pool, back);
+            iq_delete(q, back);
+            back = next;
+            dup = true;
+        }
+        if (dup)
+            iq_delete(q, front);
+        front = back;
+    }
+    return true;
+}
+
+void iq_swap(iqueue_t *q)
+{
+    if (!q)
+        return;
+    q->mid_valid = false;
+    uint32_t walk = q->head;
+    while (ilist_next(&q->pool, walk) != q->head &&
+           ilist_next(&q->pool, ilist_next(&q->pool, walk)) != q->head) {
+        uint32_t front = ilist_next(&q->pool, walk);
+        uint32_t back = ilist_next(&q->pool, front);
+        ilist_del(&q->pool, front);
+        ilist_add(&q->pool, front, back);
+        walk = front;
+    }
+}
+
+void iq_reverse(iqueue_t *q)
+{
+    if (!q)
+        return;
+    q->mid_valid = false;
+    uint32_t i = q->head;
+    do {
+        struct ilist_head *n = ipool_at(&q->pool, i);
+        uint32_t next = n->next;
+        n->next = n->prev;
+        n->prev = next;
+        i = next;
+    } while (i != q->head);
+}
+
+/*
+ * Merge sort the n nodes from first on, chained by next and ended by
+ * IPOOL_NIL.  The sentinel serves as the dummy head of every merge, which
+ * is safe since merges never overlap.  Return the new first node.
+ */
+static uint32_t iq_sort_chain(iqueue_t *q, uint32_t first, size_t n)
+{
+    if (n < 2)
+        return first;
+    uint32_t mid = first;
+    for (size_t k = n / 2 - 1; k; k--)
+        mid = ilist_next(&q->pool, mid);
+    uint32_t second = ilist_next(&q->pool, mid);
+    ipool_at(&q->pool, mid)->next = IPOOL_NIL;
+
+    uint32_t a = iq_sort_chain(q, first, n / 2);
+    uint32_t b = iq_sort_chain(q, second, n - n / 2);
+    uint32_t tail = q->head;
+    while (a != IPOOL_NIL && b != IPOOL_NIL) {
+        /* Take a on ties, which keeps the sort stable */
+        uint32_t *from = iq_cmp(q, a, b) <= 0 ? &a : &b;
+        ipool_at(&q->pool, tail)->next = *from;
+        tail = *from;
+        *from = ilist_next(&q->pool, *from);
+    }
+    ipool_at(&q->pool, tail)->next = a != IPOOL_NIL ? a : b;
+    return ilist_next(&q->pool, q->head);
+}
+
+void iq_sort(iqueue_t *q)
+{
+    if (!q || q->size < 2)
+        return;
+    q->mid_valid = false;
+    ipool_at(&q->pool, ilist_prev(&q->pool, q->head))->next = IPOOL_NIL;
+    uint32_t first = iq_sort_chain(q, ilist_next(&q->pool, q->head), q->size);
+
+    /* Restore the prev links and close the circle */
+    uint32_t prev = q->head;
+    ipool_at(&q->pool, q->head)->next = first;
+    for (uint32_t i = first; i != IPOOL_NIL; i = ilist_next(&q->pool, i)) {
+        ipool_at(&q->pool, i)->prev = prev;
+        prev = i;
+    }
+    ipool_at(&q->pool, prev)->next = q->head;
+    ipool_at(&q->pool, q->head)->prev = prev;
+}
@@ -0,0 +1,118 @@
+#ifndef LAB0_IQUEUE_H
+#define LAB0_IQUEUE_H
+
+/*
+ * Compact queue for large numbers of short strings.
+ *
+ * Nodes are 24 bytes, linked by 32-bit index through ilist.h, and carved
+ * from a per-queue struct ipool.  Strings shorter than IQ_INLINE_LEN are
+ * stored in the node itself; longer ones go to a per-queue arena, or to
+ * malloc if they are too long for the arena, and the node keeps a pointer.
+ *
+ * The operations mirror those of queue.h and are ports of queue.c onto the
+ * ilist.h calls.  There are no element_t objects, so removals copy the
+ * value out and release it in the same step.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "arena.h"
+#include "ilist.h"
+
+#define IQ_INLINE_LEN 12
+
+struct iq_node {
+    struct ilist_head list;
+    uint32_t len;
+    /* The string if shorter than IQ_INLINE_LEN, else a pointer to it */
+    char str[IQ_INLINE_LEN];
+};
+
+typedef struct {
+    struct ipool pool;
+    /* Index of the sentinel node */
+    uint32_t head;
+    size_t size;
+    struct arena strs;
+    /*
+     * Middle cursor, as in queue.c: node size / 2 counting along next from
+     * the sentinel, or the sentinel when empty.  Insertions and removals at
+     * either end move it by a node at most; operations on the whole queue
+     * clear mid_valid, and iq_delete_mid seeks it again.
+     */
+    uint32_t mid;
+    bool mid_valid;
+} iqueue_t;
+
+static inline struct iq_node *iq_node(const iqueue_t *q, uint32_t i)
+{
+    return ilist_entry(&q->pool, i, struct iq_node);
+}
+
+/* String held by node i */
+static inline char *iq_value(const iqueue_t *q, uint32_t i)
+{
+    struct iq_node *n = iq_node(q, i);
+    if (n->len < IQ_INLINE_LEN)
+        return n->str;
+    char *v;
+    memcpy(&v, n->str, sizeof(v));
+    return v;
+}
+
+/* Create an empty queue.  Return NULL if could not allocate space. */
+iqueue_t *iq_new();
+
+/* Free all storage used by queue, no effect if q is NULL */
+void iq_free(iqueue_t *q);
+
+/*
+ * Insert a copy of s at head or tail of queue.
+ * Return false if q is NULL or could not allocate space.
+ */
+bool iq_insert_head(iqueue_t *q, char *s);
+bool iq_insert_tail(iqueue_t *q, char *s);
+
+/*
+ * Insert copies of s[0] .. s[n - 1] as iq_insert_head or iq_insert_tail
+ * would one at a time.  On failure the queue is left unchanged.
+ */
+bool iq_insert_head_n(iqueue_t *q, char **s, size_t n);
+bool iq_insert_tail_n(iqueue_t *q, char **s, size_t n);
+
+/*
+ * Remove the value at head or tail of queue.  If sp is non-NULL, copy the
+ * value to *sp, at most bufsize - 1 characters plus a null terminator.
+ * Return false if q is NULL or empty.
+ */
+bool iq_remove_head(iqueue_t *q, char *sp, size_t bufsize);
+bool iq_remove_tail(iqueue_t *q, char *sp, size_t bufsize);
+
+/* Return number of values in queue, 0 if q is NULL */
+size_t iq_size(iqueue_t *q);
+
+/*
+ * Delete the value at index size / 2, counting from 0 at the head.
+ * Return false if q is NULL or empty.
+ */
+bool iq_delete_mid(iqueue_t *q);
+
+/*
+ * Delete every value that occurs more than once in a sorted queue.
+ * Return false if q is NULL or empty.
+ */
+bool iq_delete_dup(iqueue_t *q);
+
+/* Swap every two adjacent values */
+void iq_swap(iqueue_t *q);
+
+/* Reverse the order of the values.  Allocates and frees nothing. */
+void iq_reverse(iqueue_t *q);
+
+/* Sort values in ascending order.  Allocates and frees nothing. */
+void iq_sort(iqueue_t *q);
+
+#endif /* LAB0_IQUEUE_H */
@@ -12,7 +12,7 @@ int compare_entry(void *priv, struct list_head *a, struct list_head *b)
 {
     element_t *ca = list_entry(a, element_t, list);
     element_t *cb = list_entry(b, element_t, list);
-    return strcmp(ca->value, cb->value);
+    return q_cmp(ca, cb);
 }
 
 
@@ -185,7 +185,10 @@ void linux_q_sort(struct list_head *head)
         return;
     void *priv = NULL;
     list_cmp_func_t *cmp = compare_entry;
+    /* As in q_sort, apply a pending reverse so that the sort stays stable */
+    q_straighten(head);
     list_sort(priv, head, cmp);
+    q_of(head)->gen++;
 }
 
 
@@ -199,7 +202,7 @@ void q_shuffle(struct list_head *head)
         return;
     srand(time(NULL));
 
-    int len = q_size(head);
+    size_t len = q_size(head);
     struct list_head *target = head->next;
     struct list_head *tail = head->prev;
     struct list_head **list_arr = malloc(len * sizeof(struct list_head *));
@@ -207,12 +210,13 @@ void q_shuffle(struct list_head *head)
         printf("list_arr malloc failed\n");
         return;
     }
-    for (int i = 0; i < len; ++i) {
+    for (size_t i = 0; i < len; ++i) {
         list_arr[i] = target;
         target = target->next;
     }
     while (len) {
-        int random = rand() % len;
+        /* rand() only yields 31 bits, too few past 2^31 elements */
+        size_t random = ((size_t) rand() << 31 | rand()) % len;
         if (random == len - 1) {
             tail = tail->prev;
             len--;
@@ -236,4 +240,5 @@ void q_shuffle(struct list_head *head)
         len--;
     }
     free(list_arr);
+    q_of(head)->gen++;
 }
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "msqueue.h"
+
+/*
+ * Links are plain pointers shared with list.h, so they are accessed with the
+ * __atomic builtins, which follow the C11 memory model.  Publishing a hazard
+ * and unlinking an element are both sequentially consistent, so that either
+ * the thread publishing sees the element gone, or the one retiring it sees
+ * the hazard.
+ */
+#define load(p, order) __atomic_load_n(p, __ATOMIC_##order)
+#define store(p, v, order) __atomic_store_n(p, v, __ATOMIC_##order)
+#define cas(p, old, new)                                                  \
+    __atomic_compare_exchange_n(p, &(old), new, false, __ATOMIC_SEQ_CST, \
+                                __ATOMIC_ACQUIRE)
+
+static inline element_t *msq_entry(struct list_head *node)
+{
+    return list_entry(node, element_t, list);
+}
+
+/* Element holding a copy of s, or no string if s is NULL */
+static element_t *msq_element_new(const char *s)
+{
+    size_t len = s ? strlen(s) : 0;
+    element_t *e = malloc(sizeof(element_t));
+    if (!e)
+        return NULL;
+    if (len < Q_INLINE_LEN) {
+        e->value = e->inline_value;
+    } else if (!(e->value = malloc(len + 1))) {
+        free(e);
+        return NULL;
+    }
+    if (s)
+        memcpy(e->value, s, len + 1);
+    e->len = len;
+    e->pool = NULL;
+    e->list.prev = e->list.next = NULL;
+    return e;
+}
+
+static void msq_element_free(element_t *e)
+{
+    if (e->value != e->inline_value)
+        free(e->value);
+    free(e);
+}
+
+msqueue_t *msq_new()
+{
+    msqueue_t *q = aligned_alloc(64, sizeof(msqueue_t));
+    if (!q)
+        return NULL;
+    memset(q, 0, sizeof(msqueue_t));
+    element_t *dummy = msq_element_new(NULL);
+    if (!dummy) {
+        free(q);
+        return NULL;
+    }
+    q->head = q->tail = &dummy->list;
+    for (int i = 0; i < MSQ_MAX_THREADS; i++)
+        q->threads[i].q = q;
+    return q;
+}
+
+void msq_free(msqueue_t *q)
+{
+    if (!q)
+        return;
+    for (struct list_head *node = q->head, *next; node; node = next) {
+        next = node->next;
+        msq_element_free(msq_entry(node));
+    }
+    for (int i = 0; i < MSQ_MAX_THREADS; i++) {
+        msq_thread_t *t = &q->threads[i];
+        for (size_t j = 0; j < t->nretired; j++)
+            msq_element_free(t->retired[j]);
+    }
+    free(q);
+}
+
+msq_thread_t *msq_join(msqueue_t *q)
+{
+    for (int i = 0; i < MSQ_MAX_THREADS; i++) {
+        msq_thread_t *t = &q->threads[i];
+        bool idle = false;
+        if (__atomic_compare_exchange_n(&t->active, &idle, true, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return t;
+    }
+    return NULL;
+}
+
+void msq_leave(msq_thread_t *t)
+{
+    for (int i = 0; i < MSQ_HAZARDS; i++)
+        store(&t->hazard[i], NULL, RELEASE);
+    store(&t->active, false, RELEASE);
+}
+
+/*
+ * Publish *src as hazard i and return it, once it is known to still be there
+ * after publication, so that no thread retiring it can have missed it
+ */
+static struct list_head *msq_protect(msq_thread_t *t,
+                                     int i,
+                                     struct list_head **src)
+{
+    struct list_head *node = load(src, ACQUIRE);
+    for (;;) {
+        store(&t->hazard[i], node, SEQ_CST);
+        struct list_head *again = load(src, SEQ_CST);
+        if (again == node)
+            return node;
+        node = again;
+    }
+}
+
+/* Free the retired elements that no thread has published */
+static void msq_scan(msq_thread_t *t)
+{
+    struct list_head *hazards[MSQ_MAX_THREADS * MSQ_HAZARDS];
+    size_t n = 0;
+    for (int i = 0; i < MSQ_MAX_THREADS; i++) {
+        for (int j = 0; j < MSQ_HAZARDS; j++) {
+            struct list_head *node = load(&t->q->threads[i].hazard[j], SEQ_CST);
+            if (node)
+                hazards[n++] = node;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < t->nretired; i++) {
+        element_t *e = t->retired[i];
+        bool hazardous = false;
+        for (size_t j = 0; j < n && !hazardous; j++)
+            hazardous = hazards[j] == &e->list;
+        if (hazardous)
+            t->retired[kept++] = e;
+        else
+            msq_element_free(e);
+    }
+    t->nretired = kept;
+}
+
+static void msq_retire(msq_thread_t *t, element_t *e)
+{
+    t->retired[t->nretired++] = e;
+    if (t->nretired == MSQ_RETIRE_SCAN)
+        msq_scan(t);
+}
+
+bool msq_insert_tail(msq_thread_t *t, const char *s)
+{
+    element_t *e = msq_element_new(s);
+    if (!e)
+        return false;
+
+    msqueue_t *q = t->q;
+    for (;;) {
+        struct list_head *tail = msq_protect(t, 0, &q->tail);
+        struct list_head *next = load(&tail->next, ACQUIRE);
+        if (tail != load(&q->tail, ACQUIRE))
+            continue;
+        if (next) {
+            /* Tail lags behind, help the insertion that left it there */
+            cas(&q->tail, tail, next);
+            continue;
+        }
+        struct list_head *none = NULL;
+        if (cas(&tail->next, none, &e->list)) {
+            cas(&q->tail, tail, &e->list);
+            break;
+        }
+    }
+    store(&t->hazard[0], NULL, RELEASE);
+    return true;
+}
+
+bool msq_remove_head(msq_thread_t *t, char *sp, size_t bufsize)
+{
+    msqueue_t *q = t->q;
+    struct list_head *head;
+    for (;;) {
+        head = msq_protect(t, 0, &q->head);
+        struct list_head *tail = load(&q->tail, ACQUIRE);
+        struct list_head *next = msq_protect(t, 1, &head->next);
+        if (head != load(&q->head, ACQUIRE))
+            continue;
+        if (!next) {
+            store(&t->hazard[0], NULL, RELEASE);
+            return false;
+        }
+        if (head == tail) {
+            cas(&q->tail, tail, next);
+            continue;
+        }
+        /*
+         * The string stays put once published, and next is protected, so
+         * it can be copied before the removal is known to succeed
+         */
+        if (sp && bufsize) {
+            element_t *e = msq_entry(next);
+            size_t n = e->len < bufsize - 1 ? e->len : bufsize - 1;
+            memcpy(sp, e->value, n);
+            sp[n] = '\0';
+        }
+        if (cas(&q->head, head, next))
+            break;
+    }
+    for (int i = 0; i < MSQ_HAZARDS; i++)
+        store(&t->hazard[i], NULL, RELEASE);
+    /* next is the dummy now, the old one goes once no thread publishes it */
+    msq_retire(t, msq_entry(head));
+    return true;
+}
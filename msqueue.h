@@ -0,0 +1,85 @@
+#ifndef LAB0_MSQUEUE_H
+#define LAB0_MSQUEUE_H
+
+/*
+ * Lock-free multi-producer, multi-consumer queue.
+ *
+ * This is the queue of Michael and Scott, "Simple, Fast, and Practical
+ * Non-Blocking and Blocking Concurrent Queue Algorithms", built from
+ * element_t: list.next is the only link, updated with compare-and-swap, and
+ * list.prev is unused.  The queue always holds a dummy element at head, and
+ * a removal makes the element holding the removed string the new dummy.
+ *
+ * Removed dummies are reclaimed with hazard pointers: each thread publishes
+ * the elements it is about to read, and an element retired by a removal is
+ * only freed once no thread has it published.
+ *
+ * Threads reach the queue through a handle from msq_join, which holds their
+ * hazard pointers and retired elements.  Up to MSQ_MAX_THREADS handles can
+ * be out at once.  Storage comes from the C library rather than the test
+ * harness, whose allocator serializes threads.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "queue.h"
+
+#define MSQ_MAX_THREADS 64
+
+/* Hazard pointers per thread: a removal reads two elements at once */
+#define MSQ_HAZARDS 2
+
+/* Retired elements a thread holds before it scans for those it can free */
+#define MSQ_RETIRE_SCAN (2 * MSQ_MAX_THREADS * MSQ_HAZARDS)
+
+typedef struct msqueue msqueue_t;
+
+/* Hazard pointers and retired elements of one thread */
+typedef struct {
+    msqueue_t *q;
+    struct list_head *hazard[MSQ_HAZARDS];
+    bool active;
+    element_t *retired[MSQ_RETIRE_SCAN];
+    size_t nretired;
+} __attribute__((aligned(64))) msq_thread_t;
+
+struct msqueue {
+    /*
+     * list members of the dummy and of the last element, each on a cache
+     * line of its own, as every operation updates one
+     */
+    struct list_head *head __attribute__((aligned(64)));
+    struct list_head *tail __attribute__((aligned(64)));
+    msq_thread_t threads[MSQ_MAX_THREADS];
+};
+
+/* Create an empty queue.  Return NULL if could not allocate space. */
+msqueue_t *msq_new();
+
+/*
+ * Free all storage used by queue, no effect if q is NULL.
+ * No thread may be using the queue any more.
+ */
+void msq_free(msqueue_t *q);
+
+/* Claim a handle for the calling thread, NULL if all are taken */
+msq_thread_t *msq_join(msqueue_t *q);
+
+/* Give the handle back.  Its retired elements wait for the next holder. */
+void msq_leave(msq_thread_t *t);
+
+/*
+ * Insert a copy of s at tail of queue.
+ * Return false if could not allocate space.
+ */
+bool msq_insert_tail(msq_thread_t *t, const char *s);
+
+/*
+ * Remove the string at head of queue.  If sp is non-NULL, copy it to *sp,
+ * at most bufsize - 1 characters plus a null terminator.
+ * Return false if the queue was empty.
+ */
+bool msq_remove_head(msq_thread_t *t, char *sp, size_t bufsize);
+
+#endif /* LAB0_MSQUEUE_H */
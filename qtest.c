@@ -2,6 +2,8 @@
 
 #include <errno.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <spawn.h>
 #include <stdio.h>
@@ -34,9 +36,16 @@
  */
 #include "queue.h"
 
+#include "backend.h"
 #include "console.h"
+#include "fcode.h"
+#include "hugepage.h"
+#include "intern.h"
+#include "msqueue.h"
 #include "report.h"
+#include "spsc.h"
 #include "tiny.h"
+#include "tqueue.h"
 /* Settable parameters */
 
 #define HISTORY_LEN 20
@@ -54,13 +63,41 @@ static int big_list_size = BIG_LIST;
 
 /* List being tested */
 typedef struct {
-    struct list_head *l;
+    /* Queue of the selected backend, a struct list_head * for list_ops */
+    void *l;
     /* meta data of list */
-    int size;
+    size_t size;
+    /* Equal values may share one string, see option intern */
+    bool shared;
 } list_head_meta_t;
 
 static list_head_meta_t l_meta;
 
+/* Clone of the queue kept by snapshot, and its number of elements */
+static struct list_head *snap_l = NULL;
+static size_t snap_cnt = 0;
+
+/*
+ * Further queues, numbered from 0.  pick exchanges one of them with the queue
+ * every other command works on, concat and split move elements across.
+ */
+#define QUEUE_SLOTS 8
+static list_head_meta_t slots[QUEUE_SLOTS];
+
+/*
+ * Queue of numbers for the commands prefixed with n, which exercise the typed
+ * queues of tqueue.h next to whichever queue the other commands work on
+ */
+DEFINE_QUEUE(nq, long, TQ_CMP_NUM)
+static nq_t *nq = NULL;
+static size_t ncnt = 0;
+
+/* Strings moved out of the queue by compress, front-coded */
+static fcode_t *packed = NULL;
+
+/* Backend the queue is built with, chosen with -b */
+static const queue_ops_t *qops = &list_ops;
+
 /* Number of elements in queue */
 static size_t lcnt = 0;
 
@@ -70,12 +107,32 @@ static int fail_count = 0;
 
 static int string_length = MAXSTRING;
 
+/*
+ * Large-scale mode: inserts and frees run without time limit, and inserts
+ * skip the checks on each batch, so that queues of billions of elements
+ * can be built from a trace
+ */
+static int stream_mode = 0;
+
 #define MIN_RANDSTR_LEN 5
 #define MAX_RANDSTR_LEN 10
 static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
 
 /* Forward declarations */
 static bool show_queue(int vlevel);
+static bool show_packed(int vlevel);
+
+/* Whether queues other than the current one may hold blocks */
+static bool other_queues()
+{
+    if (snap_l || nq || packed)
+        return true;
+    for (int i = 0; i < QUEUE_SLOTS; i++) {
+        if (slots[i].l)
+            return true;
+    }
+    return false;
+}
 
 static bool do_free(int argc, char *argv[])
 {
@@ -91,8 +148,8 @@ static bool do_free(int argc, char *argv[])
 
     if (lcnt > big_list_size)
         set_cautious_mode(false);
-    if (exception_setup(true))
-        q_free(l_meta.l);
+    if (exception_setup(!stream_mode))
+        qops->free(l_meta.l);
     exception_cancel();
     set_cautious_mode(true);
 
@@ -101,7 +158,15 @@ static bool do_free(int argc, char *argv[])
     lcnt = 0;
     show_queue(3);
 
-    size_t bcnt = allocation_check();
+    /*
+     * Free returns while the reclaimer may still be releasing the queue, so
+     * its leaks are counted by mem and queue_quit, which wait for it.  Those
+     * hidden by the blocks of other queues only show once queue_quit frees
+     * the latter.
+     */
+    size_t bcnt = (qops == &list_ops && q_reclaim_enabled) || other_queues()
+                      ? 0
+                      : allocation_check() + huge_regions();
     if (bcnt > 0) {
         report(1, "ERROR: Freed queue, but %lu blocks are still allocated",
                bcnt);
@@ -126,8 +191,9 @@ static bool do_new(int argc, char *argv[])
     error_check();
 
     if (exception_setup(true)) {
-        l_meta.l = q_new();
+        l_meta.l = qops->new();
         l_meta.size = 0;
+        l_meta.shared = qops == &list_ops && q_pool_enabled && q_intern_enabled;
     }
     exception_cancel();
     lcnt = 0;
@@ -152,15 +218,18 @@ static void fill_rand_string(char *buf, size_t buf_size)
     buf[len] = '\0';
 }
 
-/* insert head */
-static bool do_ih(int argc, char *argv[])
+/* How many strings ih/it hand to q_insert_*_n at once */
+#define INSERT_BATCH 1024
+
+static bool do_insert(int option, int argc, char *argv[])
 {
+    // option 0 is for insert head; option 1 is for insert tail
     if (simulation) {
         if (argc != 1) {
             report(1, "%s does not need arguments in simulation mode", argv[0]);
             return false;
         }
-        bool ok = is_insert_head_const();
+        bool ok = option ? is_insert_tail_const() : is_insert_head_const();
         if (!ok) {
             report(1, "ERROR: Probably not constant time");
             return false;
@@ -169,9 +238,7 @@ static bool do_ih(int argc, char *argv[])
         return ok;
     }
 
-    char *lasts = NULL;
-    char randstr_buf[MAX_RANDSTR_LEN];
-    int reps = 1;
+    size_t reps = 1;
     bool ok = true, need_rand = false;
     if (argc != 2 && argc != 3) {
         report(1, "%s needs 1-2 arguments", argv[0]);
@@ -180,48 +247,87 @@ static bool do_ih(int argc, char *argv[])
 
     char *inserts = argv[1];
     if (argc == 3) {
-        if (!get_int(argv[2], &reps)) {
+        if (!get_size(argv[2], &reps)) {
             report(1, "Invalid number of insertions '%s'", argv[2]);
             return false;
         }
     }
 
-    if (!strcmp(inserts, "RAND")) {
+    if (!strcmp(inserts, "RAND"))
         need_rand = true;
-        inserts = randstr_buf;
+
+    /*
+     * A failed batch inserts none of its strings, so with allocations made
+     * to fail, strings go one at a time and each failure counts
+     */
+    size_t batch_size = reps < INSERT_BATCH ? reps : INSERT_BATCH;
+    if (batch_size < 1 || fail_probability)
+        batch_size = 1;
+    char **batch = malloc(sizeof(char *) * batch_size);
+    char *randstrs = need_rand ? malloc(MAX_RANDSTR_LEN * batch_size) : NULL;
+    if (!batch || (need_rand && !randstrs)) {
+        report(1, "INTERNAL ERROR.  Could not allocate space for insertions");
+        free(batch);
+        free(randstrs);
+        return false;
     }
 
     if (!l_meta.l)
-        report(3, "Warning: Calling insert head on null queue");
+        report(3, "Warning: Calling insert %s on null queue",
+               option ? "tail" : "head");
     error_check();
 
-    if (exception_setup(true)) {
-        for (int r = 0; ok && r < reps; r++) {
-            if (need_rand)
-                fill_rand_string(randstr_buf, sizeof(randstr_buf));
-            bool rval = q_insert_head(l_meta.l, inserts);
-            if (rval) {
-                lcnt++;
-                l_meta.size++;
-                char *cur_inserts =
-                    list_entry(l_meta.l->next, element_t, list)->value;
-                if (!cur_inserts) {
-                    report(1, "ERROR: Failed to save copy of string in queue");
-                    ok = false;
-                } else if (r == 0 && inserts == cur_inserts) {
-                    report(1,
-                           "ERROR: Need to allocate and copy string for new "
-                           "queue element");
-                    ok = false;
-                    break;
-                } else if (r == 1 && lasts == cur_inserts) {
-                    report(1,
-                           "ERROR: Need to allocate separate string for each "
-                           "queue element");
-                    ok = false;
-                    break;
+    if (exception_setup(!stream_mode)) {
+        for (size_t r = 0; ok && r < reps; r += batch_size) {
+            size_t cnt = reps - r < batch_size ? reps - r : batch_size;
+            for (size_t i = 0; i < cnt; i++) {
+                batch[i] = inserts;
+                if (need_rand) {
+                    batch[i] = randstrs + i * MAX_RANDSTR_LEN;
+                    fill_rand_string(batch[i], MAX_RANDSTR_LEN);
+                }
+            }
+
+            bool rval;
+            if (cnt == 1)
+                rval = option ? qops->insert_tail(l_meta.l, batch[0])
+                              : qops->insert_head(l_meta.l, batch[0]);
+            else
+                rval = option ? qops->insert_tail_n(l_meta.l, batch, cnt)
+                              : qops->insert_head_n(l_meta.l, batch, cnt);
+            if (rval && stream_mode) {
+                lcnt += cnt;
+                l_meta.size += cnt;
+            } else if (rval) {
+                lcnt += cnt;
+                l_meta.size += cnt;
+                /* Each value inserted, from the last one, and the one before */
+                q_iter_t it;
+                bool found = option ? qops->last(l_meta.l, &it)
+                                    : qops->first(l_meta.l, &it);
+                for (size_t i = cnt; ok && i-- > 0;) {
+                    const char *cur_inserts = found ? it.value : NULL;
+                    bool has_prev = (i || r) && cur_inserts &&
+                                    (option ? qops->prev(l_meta.l, &it)
+                                            : qops->next(l_meta.l, &it));
+                    found = has_prev;
+                    if (!cur_inserts) {
+                        report(1,
+                               "ERROR: Failed to save copy of string in queue");
+                        ok = false;
+                    } else if (cur_inserts == batch[i]) {
+                        report(1,
+                               "ERROR: Need to allocate and copy string for "
+                               "new queue element");
+                        ok = false;
+                    } else if (has_prev && it.value == cur_inserts &&
+                               !l_meta.shared) {
+                        report(1,
+                               "ERROR: Need to allocate separate string for "
+                               "each queue element");
+                        ok = false;
+                    }
                 }
-                lasts = cur_inserts;
             } else {
                 fail_count++;
                 if (fail_count < fail_limit)
@@ -238,83 +344,22 @@ static bool do_ih(int argc, char *argv[])
     }
     exception_cancel();
 
+    free(batch);
+    free(randstrs);
     show_queue(3);
     return ok;
 }
 
-/* insert tail */
-static bool do_it(int argc, char *argv[])
+/* insert head */
+static inline bool do_ih(int argc, char *argv[])
 {
-    if (simulation) {
-        if (argc != 1) {
-            report(1, "%s does not need arguments in simulation mode", argv[0]);
-            return false;
-        }
-        bool ok = is_insert_tail_const();
-        if (!ok) {
-            report(1, "ERROR: Probably not constant time");
-            return false;
-        }
-        report(1, "Probably constant time");
-        return ok;
-    }
-
-    char randstr_buf[MAX_RANDSTR_LEN];
-    int reps = 1;
-    bool ok = true, need_rand = false;
-    if (argc != 2 && argc != 3) {
-        report(1, "%s needs 1-2 arguments", argv[0]);
-        return false;
-    }
-
-    char *inserts = argv[1];
-    if (argc == 3) {
-        if (!get_int(argv[2], &reps)) {
-            report(1, "Invalid number of insertions '%s'", argv[2]);
-            return false;
-        }
-    }
-
-    if (!strcmp(inserts, "RAND")) {
-        need_rand = true;
-        inserts = randstr_buf;
-    }
-
-    if (!l_meta.l)
-        report(3, "Warning: Calling insert tail on null queue");
-    error_check();
+    return do_insert(0, argc, argv);
+}
 
-    if (exception_setup(true)) {
-        for (int r = 0; ok && r < reps; r++) {
-            if (need_rand)
-                fill_rand_string(randstr_buf, sizeof(randstr_buf));
-            bool rval = q_insert_tail(l_meta.l, inserts);
-            if (rval) {
-                lcnt++;
-                l_meta.size++;
-                char *cur_inserts =
-                    list_entry(l_meta.l->prev, element_t, list)->value;
-                if (!cur_inserts) {
-                    report(1, "ERROR: Failed to save copy of string in queue");
-                    ok = false;
-                }
-            } else {
-                fail_count++;
-                if (fail_count < fail_limit)
-                    report(2, "Insertion of %s failed", inserts);
-                else {
-                    report(1,
-                           "ERROR: Insertion of %s failed (%d failures total)",
-                           inserts, fail_count);
-                    ok = false;
-                }
-            }
-            ok = ok && !error_check();
-        }
-    }
-    exception_cancel();
-    show_queue(3);
-    return ok;
+/* insert tail */
+static inline bool do_it(int argc, char *argv[])
+{
+    return do_insert(1, argc, argv);
 }
 
 static bool do_remove(int option, int argc, char *argv[])
@@ -376,19 +421,14 @@ static bool do_remove(int option, int argc, char *argv[])
         report(3, "Warning: Calling remove head on empty queue");
     error_check();
 
-    element_t *re = NULL;
+    bool removed = false;
     if (exception_setup(true))
-        re = option ? q_remove_tail(l_meta.l, removes, string_length + 1)
-                    : q_remove_head(l_meta.l, removes, string_length + 1);
+        removed =
+            option ? qops->remove_tail(l_meta.l, removes, string_length + 1)
+                   : qops->remove_head(l_meta.l, removes, string_length + 1);
     exception_cancel();
 
-    bool is_null = re ? false : true;
-
-    if (!is_null) {
-        // q_remove_head and q_remove_tail are not responsible for releasing
-        // node
-        q_release_element(re);
-
+    if (removed) {
         removes[string_length + STRINGPAD] = '\0';
         if (removes[0] == '\0') {
             report(1, "ERROR: Failed to store removed value");
@@ -449,8 +489,14 @@ static inline bool do_rt(int argc, char *argv[])
 /* remove head quietly */
 static bool do_rhq(int argc, char *argv[])
 {
-    if (argc != 1) {
-        report(1, "%s takes no arguments", argv[0]);
+    if (argc != 1 && argc != 2) {
+        report(1, "%s takes 0-1 arguments", argv[0]);
+        return false;
+    }
+
+    size_t reps = 1;
+    if (argc == 2 && !get_size(argv[1], &reps)) {
+        report(1, "Invalid number of removals '%s'", argv[1]);
         return false;
     }
 
@@ -459,17 +505,35 @@ static bool do_rhq(int argc, char *argv[])
         report(3, "Warning: Calling remove head on empty queue");
     error_check();
 
-    element_t *re = NULL;
+    if (reps > 1) {
+        size_t removed = 0;
+        if (exception_setup(!stream_mode))
+            removed = qops->remove_head_n(l_meta.l, reps);
+        exception_cancel();
+
+        report(2, "Removed %lu elements from queue", removed);
+        lcnt -= removed;
+        l_meta.size -= removed;
+        if (removed < reps) {
+            fail_count++;
+            if (fail_count < fail_limit)
+                report(2, "Removal failed");
+            else {
+                report(1, "ERROR: Removal failed (%d failures total)",
+                       fail_count);
+                ok = false;
+            }
+        }
+        show_queue(3);
+        return ok && !error_check();
+    }
 
+    bool removed = false;
     if (exception_setup(true))
-        re = q_remove_head(l_meta.l, NULL, 0);
+        removed = qops->remove_head(l_meta.l, NULL, 0);
     exception_cancel();
 
-    if (re) {
-        // q_remove_head and q_remove_tail are not responsible for releasing
-        // node
-        q_release_element(re);
-
+    if (removed) {
         report(2, "Removed element from queue");
         lcnt--;
         l_meta.size--;
@@ -487,12 +551,147 @@ static bool do_rhq(int argc, char *argv[])
     return ok && !error_check();
 }
 
+/* Commands that reach into element_t need the list backend */
+static bool need_list_backend(char *cmd)
+{
+    if (qops == &list_ops)
+        return true;
+    report(1, "%s is not supported by the %s backend", cmd, qops->name);
+    return false;
+}
+
+/* Queue values in order, taken before dedup unsorted to check it after */
+typedef struct {
+    /* The values back to back, each with its null terminator */
+    char *buf;
+    /* Offset of value i in buf, and whether it occurs more than once */
+    size_t *start;
+    bool *dup;
+    /* Number of values, and of those that occur once */
+    size_t n, once;
+} dedup_snap_t;
+
+static void dedup_snap_free(dedup_snap_t *snap)
+{
+    free(snap->buf);
+    free(snap->start);
+    free(snap->dup);
+}
+
+/* Copy the queue values and mark the repeated ones, by a table of their own */
+static bool dedup_snap_take(dedup_snap_t *snap)
+{
+    size_t n = 0, total = 0;
+    q_iter_t it;
+    for (bool more = l_meta.l && qops->first(l_meta.l, &it); more;
+         more = qops->next(l_meta.l, &it)) {
+        n++;
+        total += it.len + 1;
+    }
+    size_t cap = 16;
+    while (cap < 2 * n)
+        cap <<= 1;
+    snap->n = n;
+    snap->buf = malloc(total);
+    snap->start = malloc(n * sizeof(size_t));
+    snap->dup = calloc(n, sizeof(bool));
+    size_t *slots = calloc(cap, sizeof(size_t));
+    if (!snap->buf || !snap->start || !snap->dup || !slots) {
+        free(slots);
+        dedup_snap_free(snap);
+        return false;
+    }
+
+    size_t i = 0, off = 0;
+    for (bool more = n && qops->first(l_meta.l, &it); more;
+         more = qops->next(l_meta.l, &it), i++) {
+        memcpy(snap->buf + off, it.value, it.len + 1);
+        snap->start[i] = off;
+        off += it.len + 1;
+
+        /* Slots hold value index + 1, 0 is empty */
+        size_t h = intern_hash(it.value, it.len) & (cap - 1);
+        while (slots[h] &&
+               strcmp(snap->buf + snap->start[slots[h] - 1], it.value))
+            h = (h + 1) & (cap - 1);
+        if (slots[h])
+            snap->dup[i] = snap->dup[slots[h] - 1] = true;
+        else
+            slots[h] = i + 1;
+    }
+    free(slots);
+    snap->once = 0;
+    for (i = 0; i < n; i++)
+        snap->once += !snap->dup[i];
+    return true;
+}
+
+/* Whether the queue holds exactly the values of snap that occur once */
+static bool dedup_snap_check(const dedup_snap_t *snap)
+{
+    size_t i = 0;
+    q_iter_t it;
+    for (bool more = qops->first(l_meta.l, &it); more;
+         more = qops->next(l_meta.l, &it), i++) {
+        while (i < snap->n && snap->dup[i])
+            i++;
+        if (i == snap->n || strcmp(it.value, snap->buf + snap->start[i]))
+            return false;
+    }
+    while (i < snap->n && snap->dup[i])
+        i++;
+    return i == snap->n;
+}
+
+static bool do_dedup_unsorted(char *argv[])
+{
+    if (!need_list_backend(argv[0]))
+        return false;
+
+    if (!l_meta.l)
+        report(3, "Warning: Calling dedup on null queue");
+    error_check();
+
+    dedup_snap_t snap;
+    if (!dedup_snap_take(&snap)) {
+        report(
+            1,
+            "INTERNAL ERROR.  Could not allocate space for duplicate checking");
+        return false;
+    }
+
+    bool ok = true;
+    if (exception_setup(true))
+        ok = q_delete_dup_unsorted(l_meta.l);
+    exception_cancel();
+
+    if (!ok) {
+        /* Expected of a null or empty queue */
+        if (snap.n)
+            report(1, "ERROR: Could not delete duplicates of unsorted queue");
+    } else if (!dedup_snap_check(&snap)) {
+        report(1,
+               "ERROR: Queue does not keep the strings without duplicate in "
+               "order");
+        ok = false;
+    }
+    if (ok) {
+        lcnt = snap.once;
+        l_meta.size = snap.once;
+    }
+    dedup_snap_free(&snap);
+    show_queue(3);
+    return ok && !error_check();
+}
+
 static bool do_dedup(int argc, char *argv[])
 {
-    if (argc != 1) {
-        report(1, "%s takes no arguments", argv[0]);
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "unsorted"))) {
+        report(1, "%s takes no arguments or unsorted", argv[0]);
         return false;
     }
+    if (argc == 2)
+        return do_dedup_unsorted(argv);
 
     // establish checking list dup_value
     struct list_head *dup_value = malloc(sizeof(*dup_value));
@@ -503,20 +702,17 @@ static bool do_dedup(int argc, char *argv[])
         return false;
     }
     INIT_LIST_HEAD(dup_value);
-    element_t *item = NULL;
-    if (l_meta.l && !list_empty(l_meta.l)) {
+    q_iter_t it;
+    if (l_meta.l && qops->first(l_meta.l, &it)) {
         bool last_dup = false;
+        const char *value = it.value;
+        size_t len = it.len;
 
-        list_for_each_entry (item, l_meta.l, list) {
-            element_t *next_item;
-            if (item->list.next == l_meta.l)
-                break;
-            next_item = list_entry(item->list.next, element_t, list);
-
+        while (qops->next(l_meta.l, &it)) {
             // assume queue has been sorted
-            bool match = !strcmp(item->value, next_item->value);
+            bool match = !strcmp(value, it.value);
             if (match && !last_dup) {
-                int n = strlen(item->value) + 1;
+                int n = len + 1;
                 char *str = malloc(sizeof(*str) * n);
                 element_t *entry = malloc(sizeof(*entry));
                 if (!str || !entry) {
@@ -538,12 +734,14 @@ static bool do_dedup(int argc, char *argv[])
 
                     return false;
                 }
-                strncpy(str, item->value, n);
+                memcpy(str, value, n);
                 entry->value = str;
 
                 list_add_tail(&entry->list, dup_value);
             }
             last_dup = match;
+            value = it.value;
+            len = it.len;
             /*
              * To avoid allocate duplicated string in checking list
              * dup_value, a variable last_dup is used to record whether
@@ -568,7 +766,7 @@ static bool do_dedup(int argc, char *argv[])
     }
     bool ok = true;
     if (exception_setup(true))
-        ok = q_delete_dup(l_meta.l);
+        ok = qops->delete_dup(l_meta.l);
     exception_cancel();
 
     if (!ok) {
@@ -587,19 +785,19 @@ static bool do_dedup(int argc, char *argv[])
         return false;
     }
 
-    item = NULL;
     // Checking if there are duplicated string remain on queue.
     // If the string is duplicated at beginning, and remain
     // on the queue after call of q_dedup, return false.
     if (l_meta.size && !list_empty(dup_value)) {
         element_t *next_dup = list_first_entry(dup_value, element_t, list);
-        list_for_each_entry (item, l_meta.l, list) {
-            int cmp = strcmp(item->value, next_dup->value);
+        for (bool more = qops->first(l_meta.l, &it); more;
+             more = qops->next(l_meta.l, &it)) {
+            int cmp = strcmp(it.value, next_dup->value);
 
             // assume queue has been sorted
             while (cmp > 0 && next_dup->list.next != dup_value) {
                 next_dup = list_first_entry(&next_dup->list, element_t, list);
-                cmp = strcmp(item->value, next_dup->value);
+                cmp = strcmp(it.value, next_dup->value);
             }
             if (!cmp) {
                 report(1, "ERROR: Duplicate string remain on queue");
@@ -640,7 +838,7 @@ static bool do_reverse(int argc, char *argv[])
 
     set_noallocate_mode(true);
     if (exception_setup(true))
-        q_reverse(l_meta.l);
+        qops->reverse(l_meta.l);
     exception_cancel();
 
     set_noallocate_mode(false);
@@ -655,7 +853,7 @@ static bool do_size(int argc, char *argv[])
         return false;
     }
 
-    int reps = 1;
+    size_t reps = 1;
     bool ok = true;
     if (argc != 1 && argc != 2) {
         report(1, "%s needs 0-1 arguments", argv[0]);
@@ -663,19 +861,19 @@ static bool do_size(int argc, char *argv[])
     }
 
     if (argc == 2) {
-        if (!get_int(argv[1], &reps)) {
-            report(1, "Invalid number of calls to size '%s'", argv[2]);
+        if (!get_size(argv[1], &reps)) {
+            report(1, "Invalid number of calls to size '%s'", argv[1]);
         }
     }
 
-    int cnt = 0;
+    size_t cnt = 0;
     if (!l_meta.l)
         report(3, "Warning: Calling size on null queue");
     error_check();
 
     if (exception_setup(true)) {
-        for (int r = 0; ok && r < reps; r++) {
-            cnt = q_size(l_meta.l);
+        for (size_t r = 0; ok && r < reps; r++) {
+            cnt = qops->size(l_meta.l);
             ok = ok && !error_check();
         }
     }
@@ -683,11 +881,12 @@ static bool do_size(int argc, char *argv[])
 
     if (ok) {
         if (lcnt == cnt) {
-            report(2, "Queue size = %d", cnt);
+            report(2, "Queue size = %lu", cnt);
         } else {
             report(1,
-                   "ERROR: Computed queue size as %d, but correct value is %d",
-                   cnt, (int) lcnt);
+                   "ERROR: Computed queue size as %lu, but correct value is "
+                   "%lu",
+                   cnt, lcnt);
             ok = false;
         }
     }
@@ -704,11 +903,14 @@ bool do_sort(int argc, char *argv[])
         return false;
     }
 
+    if (argc == 2 && !need_list_backend(argv[0]))
+        return false;
+
     if (!l_meta.l)
         report(3, "Warning: Calling sort on null queue");
     error_check();
 
-    int cnt = q_size(l_meta.l);
+    size_t cnt = qops->size(l_meta.l);
     if (cnt < 2)
         report(3, "Warning: Calling sort on single node");
     error_check();
@@ -717,7 +919,7 @@ bool do_sort(int argc, char *argv[])
 
     if (argc == 1) {
         if (exception_setup(true))
-            q_sort(l_meta.l);
+            qops->sort(l_meta.l);
     } else {
         if (exception_setup(true))
             linux_q_sort(l_meta.l);
@@ -729,19 +931,18 @@ bool do_sort(int argc, char *argv[])
     set_noallocate_mode(false);
 
     bool ok = true;
-    if (l_meta.size) {
-        for (struct list_head *cur_l = l_meta.l->next;
-             cur_l != l_meta.l && --cnt; cur_l = cur_l->next) {
+    q_iter_t it;
+    if (l_meta.size && qops->first(l_meta.l, &it)) {
+        const char *value = it.value;
+        while (--cnt && qops->next(l_meta.l, &it)) {
             /* Ensure each element in ascending order */
             /* FIXME: add an option to specify sorting order */
-            element_t *item, *next_item;
-            item = list_entry(cur_l, element_t, list);
-            next_item = list_entry(cur_l->next, element_t, list);
-            if (strcasecmp(item->value, next_item->value) > 0) {
+            if (strcasecmp(value, it.value) > 0) {
                 report(1, "ERROR: Not sorted in ascending order");
                 ok = false;
                 break;
             }
+            value = it.value;
         }
     }
 
@@ -756,11 +957,14 @@ bool do_shuffle(int argc, char *argv[])
         return false;
     }
 
+    if (!need_list_backend(argv[0]))
+        return false;
+
     if (!l_meta.l)
         report(3, "Warning: Calling shuffle on null queue");
     error_check();
 
-    int cnt = q_size(l_meta.l);
+    size_t cnt = q_size(l_meta.l);
     if (cnt < 2)
         report(3, "Warning: Calling shuffle on single node");
     error_check();
@@ -775,10 +979,27 @@ bool do_shuffle(int argc, char *argv[])
     show_queue(3);
     return ok && !error_check();
 }
+/* Node that q_delete_mid should delete, found by walking from both ends */
+static struct list_head *expected_mid(struct list_head *head)
+{
+    struct list_head *front = q_next(head, head), *back = q_prev(head, head);
+    while (front != back && q_next(head, front) != back) {
+        front = q_next(head, front);
+        back = q_prev(head, back);
+    }
+    return back;
+}
+
 static bool do_dm(int argc, char *argv[])
 {
-    if (argc != 1) {
-        report(1, "%s takes no arguments", argv[0]);
+    if (argc != 1 && argc != 2) {
+        report(1, "%s takes 0-1 arguments", argv[0]);
+        return false;
+    }
+
+    size_t reps = 1;
+    if (argc == 2 && !get_size(argv[1], &reps)) {
+        report(1, "Invalid number of deletions '%s'", argv[1]);
         return false;
     }
 
@@ -786,11 +1007,36 @@ static bool do_dm(int argc, char *argv[])
         report(3, "Warning: Try to access null queue");
     error_check();
 
+    /* A single deletion is checked against the reference walk */
+    struct list_head *before = NULL, *after = NULL;
+    if (reps == 1 && qops == &list_ops && l_meta.l &&
+        !list_empty(l_meta.l)) {
+        struct list_head *mid = expected_mid(l_meta.l);
+        before = mid->prev;
+        after = mid->next;
+    }
+
     bool ok = true;
-    if (exception_setup(true))
-        ok = q_delete_mid(l_meta.l);
+    size_t deleted = 0;
+    if (exception_setup(true)) {
+        for (; ok && deleted < reps; deleted++)
+            ok = qops->delete_mid(l_meta.l);
+    }
     exception_cancel();
 
+    if (ok) {
+        lcnt -= deleted;
+        l_meta.size -= deleted;
+    } else if (deleted) {
+        lcnt -= deleted - 1;
+        l_meta.size -= deleted - 1;
+    }
+
+    if (ok && before && (before->next != after || after->prev != before)) {
+        report(1, "ERROR: Deleted node is not the middle one");
+        ok = false;
+    }
+
     show_queue(3);
     return ok && !error_check();
 }
@@ -808,7 +1054,7 @@ static bool do_swap(int argc, char *argv[])
 
     set_noallocate_mode(true);
     if (exception_setup(true))
-        q_swap(l_meta.l);
+        qops->swap(l_meta.l);
     exception_cancel();
 
     set_noallocate_mode(false);
@@ -816,6 +1062,169 @@ static bool do_swap(int argc, char *argv[])
     show_queue(3);
     return !error_check();
 }
+static bool do_compact(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!need_list_backend(argv[0]))
+        return false;
+
+    if (!l_meta.l)
+        report(3, "Warning: Calling compact on null queue");
+    error_check();
+
+    if (lcnt > big_list_size)
+        set_cautious_mode(false);
+    bool ok = true;
+    if (exception_setup(true))
+        ok = q_compact(l_meta.l);
+    exception_cancel();
+    set_cautious_mode(true);
+
+    /*
+     * Elements removed or moved to other queues that are still out make
+     * q_compact refuse by design, which is only a failure when allocations
+     * may fail too
+     */
+    if (!ok && l_meta.l && !fail_probability) {
+        report(3, "Warning: Queue not compacted, some of its elements are "
+                  "still out");
+        ok = true;
+    } else if (!ok && l_meta.l) {
+        fail_count++;
+        if (fail_count < fail_limit) {
+            report(2, "Compaction of queue failed");
+            ok = true;
+        } else {
+            report(1, "ERROR: Compaction of queue failed (%d failures total)",
+                   fail_count);
+        }
+    } else if (!ok) {
+        report(1, "Compaction of queue failed");
+    }
+
+    show_queue(3);
+    return ok && !error_check();
+}
+
+/* Cache line and page sizes assumed by locality, as shifts */
+#define LINE_SHIFT 6
+#define PAGE_SHIFT 12
+
+/* Units first to last of 1 << shift bytes, empty if first > last */
+typedef struct {
+    uintptr_t first, last;
+} span_t;
+
+static const span_t no_span = {1, 0};
+
+static span_t span_of(const void *p, size_t size, int shift)
+{
+    uintptr_t a = (uintptr_t) p;
+    return (span_t){a >> shift, (a + size - 1) >> shift};
+}
+
+/* Number of units of s that lie in neither of the disjoint spans of seen */
+static size_t new_units(span_t s, const span_t seen[2])
+{
+    size_t n = s.last - s.first + 1;
+    for (int i = 0; i < 2; i++) {
+        uintptr_t lo = s.first > seen[i].first ? s.first : seen[i].first;
+        uintptr_t hi = s.last < seen[i].last ? s.last : seen[i].last;
+        if (lo <= hi)
+            n -= hi - lo + 1;
+    }
+    return n;
+}
+
+/*
+ * Units of 1 << shift bytes that a walk along the queue touches for an
+ * element but did not for the element or the string before, counted for
+ * the elements alone and with their out-of-line strings
+ */
+typedef struct {
+    int shift;
+    span_t seen[2];
+    size_t nodes, all;
+} touch_t;
+
+static void touch(touch_t *t, const element_t *e)
+{
+    span_t node = span_of(e, sizeof(element_t), t->shift);
+    span_t str = e->value == e->inline_value
+                     ? no_span
+                     : span_of(e->value, e->len + 1, t->shift);
+    size_t fresh = new_units(node, t->seen);
+    t->nodes += fresh;
+    t->all += fresh + new_units(str, t->seen);
+    /* Nodes and strings are two streams: an inline string ends neither */
+    t->seen[0] = node;
+    if (str.first <= str.last)
+        t->seen[1] = str;
+}
+
+/*
+ * Report how far apart successive elements lie, and how many cache lines
+ * and pages a walk along the queue brings in per element
+ */
+static bool do_locality(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!need_list_backend(argv[0]))
+        return false;
+
+    if (!l_meta.l) {
+        report(3, "Warning: Calling locality on null queue");
+        return true;
+    }
+
+    /* Next slot, same 4 KiB page, same 2 MiB huge page, farther */
+    size_t strides[4] = {0, 0, 0, 0};
+    size_t n = 0, backward = 0;
+    touch_t lines = {LINE_SHIFT, {no_span, no_span}, 0, 0};
+    touch_t pages = {PAGE_SHIFT, {no_span, no_span}, 0, 0};
+    const element_t *prev = NULL;
+    q_iter_t it;
+    for (bool more = list_ops.first(l_meta.l, &it); more;
+         more = list_ops.next(l_meta.l, &it), n++) {
+        const element_t *e = list_entry(it.pos, element_t, list);
+        if (prev) {
+            intptr_t d = (const char *) e - (const char *) prev;
+            uintptr_t dist = d < 0 ? -(uintptr_t) d : (uintptr_t) d;
+            backward += d < 0;
+            strides[d == sizeof(element_t) ? 0
+                    : dist < 4096          ? 1
+                    : dist < (2 << 20)     ? 2
+                                           : 3]++;
+        }
+        touch(&lines, e);
+        touch(&pages, e);
+        prev = e;
+    }
+
+    if (n < 2) {
+        report(1, "Too few elements to measure locality");
+        return true;
+    }
+    double steps = (n - 1) / 100.0;
+    report(1,
+           "Strides: %.1f%% next slot, %.1f%% within 4 KiB, %.1f%% within "
+           "2 MiB, %.1f%% farther; %.1f%% backward",
+           strides[0] / steps, strides[1] / steps, strides[2] / steps,
+           strides[3] / steps, backward / steps);
+    report(1, "Per element: %.2f cache lines, %.3f pages; with strings %.2f "
+           "and %.3f", (double) lines.nodes / n, (double) pages.nodes / n,
+           (double) lines.all / n, (double) pages.all / n);
+    return true;
+}
+
 static bool do_web(int argc, char *argv[])
 {
     listenfd = open_listenfd(DEFAULT_PORT);
@@ -824,15 +1233,16 @@ static bool do_web(int argc, char *argv[])
 }
 static bool is_circular()
 {
-    struct list_head *cur = l_meta.l->next;
-    while (cur != l_meta.l) {
+    struct list_head *head = l_meta.l;
+    struct list_head *cur = head->next;
+    while (cur != head) {
         if (!cur)
             return false;
         cur = cur->next;
     }
 
-    cur = l_meta.l->prev;
-    while (cur != l_meta.l) {
+    cur = head->prev;
+    while (cur != head) {
         if (!cur)
             return false;
         cur = cur->prev;
@@ -846,29 +1256,30 @@ static bool show_queue(int vlevel)
     if (verblevel < vlevel)
         return true;
 
-    int cnt = 0;
+    size_t cnt = 0;
     if (!l_meta.l) {
         report(vlevel, "l = NULL");
         return true;
     }
 
-    if (!is_circular()) {
+    if (qops == &list_ops && !is_circular()) {
         report(vlevel, "ERROR:  Queue is not doubly circular");
         return false;
     }
 
     report_noreturn(vlevel, "l = [");
 
-    struct list_head *ori = l_meta.l;
-    struct list_head *cur = l_meta.l->next;
+    q_iter_t it;
+    bool more = false;
 
     if (exception_setup(true)) {
-        while (ok && ori != cur && cnt < lcnt) {
-            element_t *e = list_entry(cur, element_t, list);
+        more = qops->first(l_meta.l, &it);
+        while (ok && more && cnt < lcnt) {
             if (cnt < big_list_size)
-                report_noreturn(vlevel, cnt == 0 ? "%s" : " %s", e->value);
+                report_noreturn(vlevel, cnt == 0 ? "%.*s" : " %.*s",
+                                (int) it.len, it.value);
             cnt++;
-            cur = cur->next;
+            more = qops->next(l_meta.l, &it);
             ok = ok && !error_check();
         }
     }
@@ -879,14 +1290,14 @@ static bool show_queue(int vlevel)
         return false;
     }
 
-    if (cur == ori) {
+    if (!more) {
         if (cnt <= big_list_size)
             report(vlevel, "]");
         else
             report(vlevel, " ... ]");
     } else {
         report(vlevel, " ... ]");
-        report(vlevel, "ERROR:  Queue has more than %d elements", lcnt);
+        report(vlevel, "ERROR:  Queue has more than %lu elements", lcnt);
         ok = false;
     }
 
@@ -899,7 +1310,1140 @@ static bool do_show(int argc, char *argv[])
         report(1, "%s takes no arguments", argv[0]);
         return false;
     }
-    return show_queue(0);
+    bool ok = show_queue(0);
+    return show_packed(0) && ok;
+}
+
+/* Resident set size in KiB, 0 if it cannot be determined */
+static size_t resident_kib()
+{
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f)
+        return 0;
+    unsigned long pages = 0;
+    if (fscanf(f, "%*u %lu", &pages) != 1)
+        pages = 0;
+    fclose(f);
+    return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* Anonymous memory backed by huge pages in KiB, 0 if it cannot be read */
+static size_t huge_resident_kib()
+{
+    FILE *f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f)
+        return 0;
+    char line[128];
+    unsigned long kib = 0;
+    while (fgets(line, sizeof(line), f) &&
+           sscanf(line, "AnonHugePages: %lu kB", &kib) != 1)
+        ;
+    fclose(f);
+    return kib;
+}
+
+/* Whether lists a and b hold the same strings in the same order */
+static bool same_values(struct list_head *a, struct list_head *b)
+{
+    q_iter_t ia, ib;
+    bool more_a = a && list_ops.first(a, &ia);
+    bool more_b = b && list_ops.first(b, &ib);
+    for (; more_a && more_b;
+         more_a = list_ops.next(a, &ia), more_b = list_ops.next(b, &ib)) {
+        if (ia.len != ib.len || memcmp(ia.value, ib.value, ia.len))
+            return false;
+    }
+    return !more_a && !more_b;
+}
+
+static bool do_snapshot(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!need_list_backend(argv[0]))
+        return false;
+
+    if (!l_meta.l)
+        report(3, "Warning: Calling snapshot on null queue");
+    error_check();
+
+    struct list_head *l = NULL;
+    if (exception_setup(true))
+        l = q_clone(l_meta.l);
+    exception_cancel();
+
+    bool ok = true;
+    if (l_meta.l && !l) {
+        report(1, "Snapshot of queue failed");
+        ok = false;
+    } else if (!same_values(l, l_meta.l)) {
+        report(1, "ERROR: Clone does not hold the strings of its queue");
+        ok = false;
+    }
+    if (ok) {
+        q_free(snap_l);
+        snap_l = l;
+        snap_cnt = lcnt;
+    } else {
+        q_free(l);
+    }
+    return ok && !error_check();
+}
+
+static bool do_restore(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!need_list_backend(argv[0]))
+        return false;
+
+    if (!snap_l)
+        report(3, "Warning: Restoring a null snapshot");
+    error_check();
+
+    if (lcnt > big_list_size)
+        set_cautious_mode(false);
+    struct list_head *l = NULL;
+    if (exception_setup(true)) {
+        q_free(l_meta.l);
+        l_meta.l = NULL;
+        l = q_clone(snap_l);
+    }
+    exception_cancel();
+    set_cautious_mode(true);
+
+    bool ok = true;
+    if (snap_l && !l) {
+        report(1, "Restore of snapshot failed");
+        ok = false;
+    } else if (!same_values(l, snap_l)) {
+        report(1, "ERROR: Clone does not hold the strings of its queue");
+        ok = false;
+    }
+    l_meta.l = l;
+    lcnt = l ? snap_cnt : 0;
+    l_meta.size = lcnt;
+    show_queue(3);
+    return ok && !error_check();
+}
+
+/* Parse the number of a queue in slots */
+static bool get_slot(char *vname, int *slot)
+{
+    if (!get_int(vname, slot) || *slot < 0 || *slot >= QUEUE_SLOTS) {
+        report(1, "Invalid queue number '%s', expected 0-%d", vname,
+               QUEUE_SLOTS - 1);
+        return false;
+    }
+    return true;
+}
+
+static bool do_pick(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs 1 argument", argv[0]);
+        return false;
+    }
+
+    int k;
+    if (!get_slot(argv[1], &k))
+        return false;
+
+    list_head_meta_t cur = l_meta;
+    l_meta = slots[k];
+    slots[k] = cur;
+    lcnt = l_meta.size;
+    show_queue(3);
+    return true;
+}
+
+/* Value at the tail of list l, NULL if there is none */
+static const char *last_value(struct list_head *l)
+{
+    q_iter_t it;
+    return l && list_ops.last(l, &it) ? it.value : NULL;
+}
+
+/*
+ * Check that dst and src hold size_dst and size_src elements after a move,
+ * and that tail, the value that was last before it, is now last in dst
+ */
+static bool check_move(char *cmd,
+                       list_head_meta_t *dst,
+                       list_head_meta_t *src,
+                       const char *tail)
+{
+    if (q_size(dst->l) != dst->size || q_size(src->l) != src->size) {
+        report(1,
+               "ERROR: %s left queues of %lu and %lu elements, expected "
+               "%lu and %lu",
+               cmd, q_size(dst->l), q_size(src->l), dst->size,
+               src->size);
+        return false;
+    }
+    if (tail && last_value(dst->l) != tail) {
+        report(1, "ERROR: %s did not keep the last element at the tail", cmd);
+        return false;
+    }
+    return true;
+}
+
+static bool do_concat(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs 1 argument", argv[0]);
+        return false;
+    }
+
+    if (!need_list_backend(argv[0]))
+        return false;
+
+    int k;
+    if (!get_slot(argv[1], &k))
+        return false;
+    list_head_meta_t *src = &slots[k];
+
+    if (!l_meta.l || !src->l)
+        report(3, "Warning: Calling concat on null queue");
+    error_check();
+
+    const char *tail = src->size ? last_value(src->l) : last_value(l_meta.l);
+    bool ok = false;
+    set_noallocate_mode(true);
+    if (exception_setup(true))
+        ok = q_concat(l_meta.l, src->l);
+    exception_cancel();
+    set_noallocate_mode(false);
+
+    if (ok) {
+        l_meta.size += src->size;
+        l_meta.shared = l_meta.shared || src->shared;
+        src->size = 0;
+        lcnt = l_meta.size;
+        ok = check_move(argv[0], &l_meta, src, tail);
+    } else {
+        report(1, "Concatenation of queues failed");
+    }
+
+    show_queue(3);
+    return ok && !error_check();
+}
+
+static bool do_split(int argc, char *argv[])
+{
+    if (argc != 3) {
+        report(1, "%s needs 2 arguments", argv[0]);
+        return false;
+    }
+
+    if (!need_list_backend(argv[0]))
+        return false;
+
+    size_t n;
+    int k;
+    if (!get_size(argv[1], &n)) {
+        report(1, "Invalid index '%s'", argv[1]);
+        return false;
+    }
+    if (!get_slot(argv[2], &k))
+        return false;
+    list_head_meta_t *dst = &slots[k];
+
+    if (!l_meta.l || !dst->l)
+        report(3, "Warning: Calling split on null queue");
+    error_check();
+
+    size_t moved = n < l_meta.size ? l_meta.size - n : 0;
+    const char *tail = moved ? last_value(l_meta.l) : last_value(dst->l);
+    bool ok = false;
+    set_noallocate_mode(true);
+    if (exception_setup(true))
+        ok = q_split(l_meta.l, n, dst->l);
+    exception_cancel();
+    set_noallocate_mode(false);
+
+    if (ok) {
+        l_meta.size -= moved;
+        dst->size += moved;
+        dst->shared = dst->shared || l_meta.shared;
+        lcnt = l_meta.size;
+        ok = check_move(argv[0], dst, &l_meta, tail);
+    } else {
+        report(1, "Split of queue failed");
+    }
+
+    show_queue(3);
+    return ok && !error_check();
+}
+
+static bool do_mem(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    q_reclaim_wait();
+    size_t bytes = allocation_bytes();
+    report(1, "Allocated %lu blocks, %lu bytes, RSS %lu KiB",
+           allocation_check(), bytes, resident_kib());
+    if (huge_regions())
+        report(1, "Mapped %lu huge page regions, %lu bytes, %lu KiB on huge "
+               "pages", huge_regions(), huge_bytes(), huge_resident_kib());
+    if (lcnt)
+        report(1, "%.1f bytes per element",
+               (double) (bytes + huge_bytes()) / lcnt);
+    else if (ncnt)
+        report(1, "%.1f bytes per number", (double) bytes / ncnt);
+    if (packed)
+        report(1, "Compressed %lu strings into %lu bytes, %.1f per string",
+               fc_size(packed), fc_bytes(packed),
+               fc_size(packed) ? (double) fc_bytes(packed) / fc_size(packed)
+                               : 0.0);
+    return true;
+}
+
+/* Walk the numeric queue, printing it at verbosity vlevel */
+static bool show_nqueue(int vlevel)
+{
+    if (verblevel < vlevel)
+        return true;
+    if (!nq) {
+        report(vlevel, "n = NULL");
+        return true;
+    }
+
+    report_noreturn(vlevel, "n = [");
+    size_t cnt = 0;
+    struct list_head *node;
+    list_for_each (node, &nq->head) {
+        if (cnt < big_list_size)
+            report_noreturn(vlevel, cnt ? " %ld" : "%ld", *nq_value(node));
+        cnt++;
+    }
+    report(vlevel, cnt > big_list_size ? " ... ]" : "]");
+
+    if (cnt != ncnt) {
+        report(vlevel, "ERROR:  Queue has %lu values, expected %lu", cnt,
+               ncnt);
+        return false;
+    }
+    return true;
+}
+
+static bool do_nfree(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!nq)
+        report(3, "Warning: Calling free on null queue");
+    error_check();
+
+    if (ncnt > big_list_size)
+        set_cautious_mode(false);
+    if (exception_setup(!stream_mode))
+        nq_free(nq);
+    exception_cancel();
+    set_cautious_mode(true);
+
+    nq = NULL;
+    ncnt = 0;
+    show_nqueue(3);
+    return !error_check();
+}
+
+static bool do_nnew(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    bool ok = true;
+    if (nq) {
+        report(3, "Freeing old queue");
+        ok = do_nfree(argc, argv);
+    }
+    error_check();
+
+    if (exception_setup(true))
+        nq = nq_new();
+    exception_cancel();
+    ncnt = 0;
+    show_nqueue(3);
+    return ok && !error_check();
+}
+
+static bool do_ninsert(int option, int argc, char *argv[])
+{
+    // option 0 is for insert head; option 1 is for insert tail
+    if (argc != 2 && argc != 3) {
+        report(1, "%s needs 1-2 arguments", argv[0]);
+        return false;
+    }
+
+    long value = 0;
+    bool need_rand = !strcmp(argv[1], "RAND");
+    if (!need_rand && !get_long(argv[1], &value)) {
+        report(1, "Invalid number '%s'", argv[1]);
+        return false;
+    }
+    size_t reps = 1;
+    if (argc == 3 && !get_size(argv[2], &reps)) {
+        report(1, "Invalid number of insertions '%s'", argv[2]);
+        return false;
+    }
+
+    if (!nq)
+        report(3, "Warning: Calling insert on null queue");
+    error_check();
+
+    if (exception_setup(!stream_mode)) {
+        for (size_t r = 0; r < reps; r++) {
+            long v = need_rand ? rand() : value;
+            if (!(option ? nq_insert_tail(nq, v) : nq_insert_head(nq, v)))
+                break;
+        }
+    }
+    exception_cancel();
+
+    /* The queue counts its own insertions, even when an alarm cut them off */
+    size_t inserted = nq_size(nq) - ncnt;
+    ncnt += inserted;
+    bool ok = true;
+    if (inserted < reps) {
+        fail_count++;
+        if (fail_count < fail_limit) {
+            report(2, "Insertion of %s failed", argv[1]);
+        } else {
+            report(1, "ERROR: Insertion of %s failed (%d failures total)",
+                   argv[1], fail_count);
+            ok = false;
+        }
+    }
+
+    show_nqueue(3);
+    return ok && !error_check();
+}
+
+static inline bool do_nih(int argc, char *argv[])
+{
+    return do_ninsert(0, argc, argv);
+}
+
+static inline bool do_nit(int argc, char *argv[])
+{
+    return do_ninsert(1, argc, argv);
+}
+
+static bool do_nremove(int option, int argc, char *argv[])
+{
+    // option 0 is for remove head; option 1 is for remove tail
+    if (argc != 1 && argc != 2) {
+        report(1, "%s needs 0-1 arguments", argv[0]);
+        return false;
+    }
+
+    long expected = 0;
+    bool check = argc > 1;
+    if (check && !get_long(argv[1], &expected)) {
+        report(1, "Invalid number '%s'", argv[1]);
+        return false;
+    }
+
+    if (!ncnt)
+        report(3, "Warning: Calling remove head on empty queue");
+    error_check();
+
+    long v = 0;
+    bool removed = false;
+    if (exception_setup(true))
+        removed = option ? nq_remove_tail(nq, &v) : nq_remove_head(nq, &v);
+    exception_cancel();
+
+    bool ok = true;
+    if (removed) {
+        report(2, "Removed %ld from queue", v);
+        ncnt--;
+    } else {
+        fail_count++;
+        if (!check && fail_count < fail_limit) {
+            report(2, "Removal from queue failed");
+        } else {
+            report(1, "ERROR: Removal from queue failed (%d failures total)",
+                   fail_count);
+            ok = false;
+        }
+    }
+
+    if (ok && check && v != expected) {
+        report(1, "ERROR: Removed value %ld != expected value %ld", v,
+               expected);
+        ok = false;
+    }
+
+    show_nqueue(3);
+    return ok && !error_check();
+}
+
+static inline bool do_nrh(int argc, char *argv[])
+{
+    return do_nremove(0, argc, argv);
+}
+
+static inline bool do_nrt(int argc, char *argv[])
+{
+    return do_nremove(1, argc, argv);
+}
+
+static bool do_nsort(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!nq)
+        report(3, "Warning: Calling sort on null queue");
+    error_check();
+
+    set_noallocate_mode(true);
+    if (exception_setup(true))
+        nq_sort(nq);
+    exception_cancel();
+    set_noallocate_mode(false);
+
+    bool ok = true;
+    if (nq) {
+        struct list_head *node;
+        list_for_each (node, &nq->head) {
+            if (node->next != &nq->head &&
+                *nq_value(node) > *nq_value(node->next)) {
+                report(1, "ERROR: Not sorted in ascending order");
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    show_nqueue(3);
+    return ok && !error_check();
+}
+
+static bool do_ndedup(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!nq)
+        report(3, "Warning: Calling dedup on null queue");
+    error_check();
+
+    /* Values in runs of equal neighbours are the ones to go */
+    size_t dups = 0;
+    if (nq) {
+        struct list_head *node;
+        list_for_each (node, &nq->head) {
+            bool same_prev = node->prev != &nq->head &&
+                             *nq_value(node->prev) == *nq_value(node);
+            bool same_next = node->next != &nq->head &&
+                             *nq_value(node->next) == *nq_value(node);
+            dups += same_prev || same_next;
+        }
+    }
+
+    bool ok = false;
+    set_noallocate_mode(true);
+    if (exception_setup(true))
+        ok = nq_delete_dup(nq);
+    exception_cancel();
+    set_noallocate_mode(false);
+
+    if (ok) {
+        ncnt -= dups;
+    } else {
+        report(1, "ERROR: Calling dedup on null queue");
+    }
+
+    ok = show_nqueue(3) && ok;
+    return ok && !error_check();
+}
+
+static bool do_nshow(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+    return show_nqueue(0);
+}
+
+/* Walk the compressed store, printing it at verbosity vlevel */
+static bool show_packed(int vlevel)
+{
+    if (verblevel < vlevel || !packed)
+        return true;
+
+    report_noreturn(vlevel, "packed = [");
+    struct fc_cursor c;
+    fc_cursor_init(&c);
+    size_t cnt = 0;
+    bool more = false;
+    if (exception_setup(true)) {
+        for (more = fc_seek(packed, 0, &c); more && cnt < big_list_size;
+             more = fc_next(packed, &c))
+            report_noreturn(vlevel, cnt++ ? " %s" : "%s", c.str);
+    }
+    exception_cancel();
+    fc_cursor_free(&c);
+    report(vlevel, more ? " ... ]" : "]");
+    return !error_check();
+}
+
+static bool do_compress(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!l_meta.l)
+        report(3, "Warning: Calling compress on null queue");
+    error_check();
+
+    bool ok = true;
+    size_t before = fc_size(packed);
+    if (exception_setup(true)) {
+        if (!packed)
+            packed = fc_new();
+        ok = packed;
+        q_iter_t it;
+        bool more = ok && l_meta.l && qops->first(l_meta.l, &it);
+        for (; ok && more; more = qops->next(l_meta.l, &it))
+            ok = fc_append(packed, it.value, it.len);
+        ok = ok && fc_trim(packed);
+    }
+    exception_cancel();
+
+    /* Whatever made it into the store leaves the queue */
+    size_t moved = fc_size(packed) - before;
+    if (exception_setup(true))
+        qops->remove_head_n(l_meta.l, moved);
+    exception_cancel();
+    lcnt -= moved;
+    l_meta.size -= moved;
+
+    if (ok) {
+        report(2, "Compressed %lu strings", moved);
+    } else {
+        report(1, "ERROR: Compression failed after %lu strings", moved);
+    }
+
+    show_queue(3);
+    show_packed(3);
+    return ok && !error_check();
+}
+
+static bool do_decompress(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!l_meta.l)
+        report(3, "Warning: Calling decompress on null queue");
+    if (!packed)
+        report(3, "Warning: Nothing is compressed");
+    error_check();
+
+    /*
+     * Each string goes once it is in the queue, so that a failed insertion
+     * loses nothing.  Removal decodes it again, which is cheap.
+     */
+    bool ok = true;
+    size_t moved = 0;
+    struct fc_cursor c;
+    fc_cursor_init(&c);
+    if (exception_setup(true)) {
+        bool more = l_meta.l && fc_seek(packed, 0, &c);
+        for (; ok && more; more = fc_next(packed, &c)) {
+            ok = qops->insert_tail(l_meta.l, c.str) &&
+                 fc_remove_head(packed, NULL, 0);
+            moved += ok;
+        }
+    }
+    exception_cancel();
+    fc_cursor_free(&c);
+    lcnt += moved;
+    l_meta.size += moved;
+
+    if (!fc_size(packed)) {
+        fc_free(packed);
+        packed = NULL;
+    }
+
+    if (ok) {
+        report(2, "Decompressed %lu strings", moved);
+    } else {
+        report(1, "ERROR: Decompression failed after %lu strings", moved);
+    }
+
+    show_queue(3);
+    show_packed(3);
+    return ok && !error_check();
+}
+
+/* Remove head of the compressed store */
+static bool do_prh(int argc, char *argv[])
+{
+    if (argc != 1 && argc != 2) {
+        report(1, "%s needs 0-1 arguments", argv[0]);
+        return false;
+    }
+
+    char *removes = malloc(string_length + 1);
+    if (!removes) {
+        report(1,
+               "INTERNAL ERROR.  Could not allocate space for removed strings");
+        return false;
+    }
+
+    if (!fc_size(packed))
+        report(3, "Warning: Calling remove head on empty store");
+    error_check();
+
+    bool removed = false;
+    if (exception_setup(true))
+        removed = fc_remove_head(packed, removes, string_length + 1);
+    exception_cancel();
+
+    bool ok = true;
+    if (removed) {
+        report(2, "Removed %s from store", removes);
+    } else {
+        fail_count++;
+        if (argc == 1 && fail_count < fail_limit) {
+            report(2, "Removal from store failed");
+        } else {
+            report(1, "ERROR: Removal from store failed (%d failures total)",
+                   fail_count);
+            ok = false;
+        }
+    }
+
+    if (ok && argc == 2 && strncmp(removes, argv[1], string_length)) {
+        report(1, "ERROR: Removed value %s != expected value %s", removes,
+               argv[1]);
+        ok = false;
+    }
+
+    show_packed(3);
+    free(removes);
+    return ok && !error_check();
+}
+
+/* Monotonic clock in nanoseconds */
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Latencies by power of two: bucket i counts those under 2^i ns */
+#define LAT_BUCKETS 40
+
+typedef struct {
+    uint64_t count[LAT_BUCKETS];
+} lat_hist_t;
+
+static void lat_add(lat_hist_t *h, uint64_t ns)
+{
+    int i = 0;
+    while (i < LAT_BUCKETS - 1 && ns >> i)
+        i++;
+    h->count[i]++;
+}
+
+/* Report the percentiles of h, for operations called what */
+static void lat_report(const char *what, const lat_hist_t *h)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < LAT_BUCKETS; i++)
+        total += h->count[i];
+    if (!total)
+        return;
+
+    static const double pct[] = {0.5, 0.9, 0.99, 0.999, 1.0};
+    static const char *names[] = {"p50", "p90", "p99", "p99.9", "max"};
+    report_noreturn(1, "%s latency:", what);
+    uint64_t seen = 0;
+    int p = 0;
+    for (int i = 0; i < LAT_BUCKETS && p < 5; i++) {
+        seen += h->count[i];
+        for (; p < 5 && seen >= pct[p] * total; p++)
+            report_noreturn(1, p ? ", %s < %lu ns" : " %s < %lu ns", names[p],
+                            1UL << i);
+    }
+    report(1, "");
+}
+
+/* Shared by the threads of do_mpmc */
+static struct {
+    msqueue_t *q;
+    /* Strings each producer inserts */
+    size_t per_producer;
+    int producers;
+    /* Producers still inserting, and strings inserted and removed so far */
+    int running;
+    size_t inserted, removed;
+    /* One flag per string, set once it has been removed */
+    uint8_t *seen;
+    /* Strings removed twice or out of producer order */
+    size_t errors;
+} mpmc;
+
+typedef struct {
+    int id;
+    size_t ops;
+    lat_hist_t lat;
+    pthread_t tid;
+} mpmc_worker_t;
+
+static void *mpmc_producer(void *arg)
+{
+    mpmc_worker_t *w = arg;
+    msq_thread_t *t = msq_join(mpmc.q);
+    char s[32];
+    for (size_t k = 0; k < mpmc.per_producer; k++) {
+        snprintf(s, sizeof(s), "%d:%lu", w->id, k);
+        uint64_t start = now_ns();
+        if (!msq_insert_tail(t, s))
+            break;
+        lat_add(&w->lat, now_ns() - start);
+        w->ops++;
+        __atomic_add_fetch(&mpmc.inserted, 1, __ATOMIC_RELEASE);
+    }
+    msq_leave(t);
+    __atomic_sub_fetch(&mpmc.running, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/*
+ * Remove strings until the producers are done and every string they
+ * inserted is gone.
+ * Each producer's strings must come out in the order they went in, and
+ * none twice.
+ */
+static void *mpmc_consumer(void *arg)
+{
+    mpmc_worker_t *w = arg;
+    msq_thread_t *t = msq_join(mpmc.q);
+    /* Index of the string expected next from each producer, at least */
+    size_t *next = calloc(mpmc.producers, sizeof(size_t));
+    char s[32];
+    while (next &&
+           (__atomic_load_n(&mpmc.running, __ATOMIC_ACQUIRE) ||
+            __atomic_load_n(&mpmc.removed, __ATOMIC_ACQUIRE) <
+                __atomic_load_n(&mpmc.inserted, __ATOMIC_ACQUIRE))) {
+        uint64_t start = now_ns();
+        if (!msq_remove_head(t, s, sizeof(s))) {
+            sched_yield();
+            continue;
+        }
+        lat_add(&w->lat, now_ns() - start);
+        w->ops++;
+        __atomic_add_fetch(&mpmc.removed, 1, __ATOMIC_RELEASE);
+
+        char *end;
+        unsigned long id = strtoul(s, &end, 10);
+        size_t k = strtoul(end + 1, NULL, 10);
+        if (id >= mpmc.producers || k >= mpmc.per_producer ||
+            __atomic_exchange_n(&mpmc.seen[id * mpmc.per_producer + k], 1,
+                                __ATOMIC_RELAXED) ||
+            k < next[id]) {
+            __atomic_add_fetch(&mpmc.errors, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        next[id] = k + 1;
+    }
+    if (!next)
+        __atomic_add_fetch(&mpmc.errors, 1, __ATOMIC_RELAXED);
+    free(next);
+    msq_leave(t);
+    return NULL;
+}
+
+/* Merge the histograms of workers first .. first + n - 1 */
+static lat_hist_t mpmc_lat(const mpmc_worker_t *w, int first, int n)
+{
+    lat_hist_t h = {{0}};
+    for (int i = first; i < first + n; i++) {
+        for (int j = 0; j < LAT_BUCKETS; j++)
+            h.count[j] += w[i].lat.count[j];
+    }
+    return h;
+}
+
+static bool do_mpmc(int argc, char *argv[])
+{
+    if (argc != 3 && argc != 4) {
+        report(1, "%s needs 2-3 arguments", argv[0]);
+        return false;
+    }
+
+    int producers, consumers;
+    size_t n = 100000;
+    if (!get_int(argv[1], &producers) || !get_int(argv[2], &consumers) ||
+        producers < 1 || consumers < 0 ||
+        producers + consumers > MSQ_MAX_THREADS) {
+        report(1,
+               "Invalid numbers of threads '%s' and '%s', expected at least "
+               "one producer and at most %d threads",
+               argv[1], argv[2], MSQ_MAX_THREADS);
+        return false;
+    }
+    if (argc == 4 && !get_size(argv[3], &n)) {
+        report(1, "Invalid number of insertions '%s'", argv[3]);
+        return false;
+    }
+
+    memset(&mpmc, 0, sizeof(mpmc));
+    mpmc.per_producer = n;
+    mpmc.producers = producers;
+    mpmc.running = producers;
+    mpmc.q = msq_new();
+    mpmc.seen = calloc(producers, n);
+    /* With no consumer thread, this one drains the queue as worker 0 */
+    int workers = producers + (consumers ? consumers : 1);
+    mpmc_worker_t *w = calloc(workers, sizeof(mpmc_worker_t));
+    if (!mpmc.q || !mpmc.seen || !w) {
+        report(1, "INTERNAL ERROR.  Could not allocate space for %s", argv[0]);
+        msq_free(mpmc.q);
+        free(mpmc.seen);
+        free(w);
+        return false;
+    }
+
+    /* Workers leave the signals of the test harness to this thread */
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    uint64_t start = now_ns();
+    bool ok = true;
+    for (int i = 0; i < producers + consumers; i++) {
+        bool producer = i < producers;
+        w[i].id = producer ? i : i - producers;
+        if (pthread_create(&w[i].tid, NULL,
+                           producer ? mpmc_producer : mpmc_consumer, &w[i])) {
+            report(1, "ERROR: Could not start thread %d", i);
+            /* Started producers still count themselves out when done */
+            if (producer)
+                __atomic_sub_fetch(&mpmc.running, producers - i,
+                                   __ATOMIC_RELEASE);
+            workers = i;
+            ok = false;
+            break;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    for (int i = 0; i < workers && i < producers; i++)
+        pthread_join(w[i].tid, NULL);
+    if (ok && !consumers)
+        mpmc_consumer(&w[producers]);
+    for (int i = producers; i < workers && consumers; i++)
+        pthread_join(w[i].tid, NULL);
+    double elapsed = (now_ns() - start) / 1e9;
+
+    /* Drained, it answers a removal as an empty queue.c queue does */
+    msq_thread_t *t = msq_join(mpmc.q);
+    if (ok && msq_remove_head(t, NULL, 0)) {
+        report(1, "ERROR: Queue not empty after every string was removed");
+        ok = false;
+    }
+    msq_leave(t);
+
+    if (ok && mpmc.inserted < producers * n) {
+        report(1, "ERROR: Insertion failed after %lu strings", mpmc.inserted);
+        ok = false;
+    }
+    if (mpmc.errors) {
+        report(1,
+               "ERROR: %lu strings removed twice or out of producer order",
+               mpmc.errors);
+        ok = false;
+    }
+
+    if (ok) {
+        size_t ops = mpmc.inserted + mpmc.removed;
+        report(1,
+               "%d producers, %d consumers: %lu operations in %.3f s, "
+               "%.2f million per second",
+               producers, consumers, ops, elapsed, ops / elapsed / 1e6);
+        lat_hist_t ins = mpmc_lat(w, 0, producers);
+        lat_hist_t rem = mpmc_lat(w, producers, consumers ? consumers : 1);
+        lat_report("Insert", &ins);
+        lat_report("Remove", &rem);
+    }
+
+    msq_free(mpmc.q);
+    free(mpmc.seen);
+    free(w);
+    return ok;
+}
+
+/* Shared by the threads of do_spsc */
+static struct {
+    /* Elements handed over, in order */
+    element_t *elems;
+    size_t n;
+    /* The ring, or when it is NULL the baseline: a list behind a mutex */
+    spsc_t *ring;
+    pthread_mutex_t lock;
+    struct list_head list;
+    /* Elements removed out of order */
+    size_t errors;
+} spsc;
+
+static void *spsc_producer(void *arg)
+{
+    (void) arg;
+    for (size_t k = 0; k < spsc.n; k++) {
+        element_t *e = &spsc.elems[k];
+        if (spsc.ring) {
+            while (!spsc_insert_tail(spsc.ring, e))
+                sched_yield();
+        } else {
+            pthread_mutex_lock(&spsc.lock);
+            list_add_tail(&e->list, &spsc.list);
+            pthread_mutex_unlock(&spsc.lock);
+        }
+    }
+    if (spsc.ring)
+        spsc_flush(spsc.ring);
+    return NULL;
+}
+
+static void *spsc_consumer(void *arg)
+{
+    (void) arg;
+    for (size_t k = 0; k < spsc.n;) {
+        element_t *e = NULL;
+        if (spsc.ring) {
+            e = spsc_remove_head(spsc.ring, NULL, 0);
+        } else {
+            pthread_mutex_lock(&spsc.lock);
+            if (!list_empty(&spsc.list)) {
+                e = list_first_entry(&spsc.list, element_t, list);
+                list_del(&e->list);
+            }
+            pthread_mutex_unlock(&spsc.lock);
+        }
+        if (!e) {
+            sched_yield();
+            continue;
+        }
+        if (e != &spsc.elems[k++])
+            spsc.errors++;
+    }
+    return NULL;
+}
+
+/*
+ * Hand every element from a producer thread to a consumer thread, through
+ * the ring if there is one.  Return the seconds it took, or a negative
+ * number if the threads could not be started.
+ */
+static double spsc_run()
+{
+    /* The threads leave the signals of the test harness to this one */
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    uint64_t start = now_ns();
+    pthread_t producer, consumer;
+    bool ok = !pthread_create(&consumer, NULL, spsc_consumer, NULL);
+    if (ok && pthread_create(&producer, NULL, spsc_producer, NULL)) {
+        /* With no producer, the consumer waits for what this one inserts */
+        spsc_producer(NULL);
+    } else if (ok) {
+        pthread_join(producer, NULL);
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (ok)
+        pthread_join(consumer, NULL);
+    return ok ? (now_ns() - start) / 1e9 : -1;
+}
+
+static bool do_spsc(int argc, char *argv[])
+{
+    if (argc > 3) {
+        report(1, "%s takes 0-2 arguments", argv[0]);
+        return false;
+    }
+
+    size_t n = 1000000, capacity = 1024;
+    if (argc > 1 && (!get_size(argv[1], &n) || !n)) {
+        report(1, "Invalid number of elements '%s'", argv[1]);
+        return false;
+    }
+    if (argc > 2 && (!get_size(argv[2], &capacity) || !capacity)) {
+        report(1, "Invalid capacity '%s'", argv[2]);
+        return false;
+    }
+
+    memset(&spsc, 0, sizeof(spsc));
+    spsc.n = n;
+    spsc.elems = calloc(n, sizeof(element_t));
+    spsc.ring = spsc_new(capacity);
+    if (!spsc.elems || !spsc.ring) {
+        report(1, "INTERNAL ERROR.  Could not allocate space for %s", argv[0]);
+        free(spsc.elems);
+        spsc_free(spsc.ring);
+        return false;
+    }
+    for (size_t k = 0; k < n; k++)
+        spsc.elems[k].value = spsc.elems[k].inline_value;
+
+    bool ok = true;
+    double ring_time = spsc_run();
+    spsc_free(spsc.ring);
+    spsc.ring = NULL;
+    pthread_mutex_init(&spsc.lock, NULL);
+    INIT_LIST_HEAD(&spsc.list);
+    double list_time = ring_time < 0 ? -1 : spsc_run();
+    pthread_mutex_destroy(&spsc.lock);
+
+    if (ring_time < 0 || list_time < 0) {
+        report(1, "ERROR: Could not start threads");
+        ok = false;
+    } else if (spsc.errors) {
+        report(1, "ERROR: %lu elements removed out of order", spsc.errors);
+        ok = false;
+    } else {
+        report(1, "Ring: %lu operations in %.3f s, %.2f million per second",
+               2 * n, ring_time, 2 * n / ring_time / 1e6);
+        report(1,
+               "Mutex list: %lu operations in %.3f s, %.2f million per second",
+               2 * n, list_time, 2 * n / list_time / 1e6);
+        report(1, "Ring is %.1f times as fast", list_time / ring_time);
+    }
+
+    free(spsc.elems);
+    return ok;
 }
 
 static void console_init()
@@ -922,27 +2466,100 @@ static void console_init()
         rt,
         " [str]          | Remove from tail of queue.  Optionally compare "
         "to expected value str");
-    ADD_COMMAND(
-        rhq,
-        "                | Remove from head of queue without reporting value.");
+    ADD_COMMAND(rhq,
+                " [n]            | Remove from head of queue n times without "
+                "reporting value. (default: n == 1)");
     ADD_COMMAND(reverse, "                | Reverse queue");
     ADD_COMMAND(sort, "                | Sort queue in ascending order");
     ADD_COMMAND(shuffle, "                | Shuffle queue.");
     ADD_COMMAND(
         size, " [n]            | Compute queue size n times (default: n == 1)");
     ADD_COMMAND(show, "                | Show queue contents");
-    ADD_COMMAND(dm, "                | Delete middle node in queue");
-    ADD_COMMAND(
-        dedup, "                | Delete all nodes that have duplicate string");
+    ADD_COMMAND(dm,
+                " [n]            | Delete middle node in queue n times "
+                "(default: n == 1)");
+    ADD_COMMAND(dedup,
+                " [unsorted]     | Delete all nodes that have duplicate string, "
+                "by hashing if unsorted");
     ADD_COMMAND(swap,
                 "                | Swap every two adjacent nodes in queue");
     ADD_COMMAND(web, "                | Launch tiny web server");
+    ADD_COMMAND(mem, "                | Show memory held by the queue");
+    ADD_COMMAND(compact,
+                "                | Move queue elements and strings into "
+                "contiguous memory in queue order");
+    ADD_COMMAND(locality,
+                "                | Report how scattered queue elements are");
+    ADD_COMMAND(snapshot,
+                "                | Keep a clone of the queue for restore");
+    ADD_COMMAND(restore,
+                "                | Replace the queue with a clone of the "
+                "snapshot");
+    ADD_COMMAND(pick,
+                " k              | Exchange the queue with further queue k, "
+                "0 to 7");
+    ADD_COMMAND(concat,
+                " k              | Move all of queue k to the tail of the "
+                "queue");
+    ADD_COMMAND(split,
+                " n k            | Move the queue from index n on to the tail "
+                "of queue k");
+    ADD_COMMAND(nnew, "                | Create new queue of numbers");
+    ADD_COMMAND(nfree, "                | Delete queue of numbers");
+    ADD_COMMAND(nih,
+                " x [n]          | Insert number x at head of queue of numbers "
+                "n times.  Random numbers if x equals RAND. (default: n == 1)");
+    ADD_COMMAND(nit,
+                " x [n]          | Insert number x at tail of queue of numbers "
+                "n times.  Random numbers if x equals RAND. (default: n == 1)");
+    ADD_COMMAND(nrh,
+                " [x]            | Remove from head of queue of numbers.  "
+                "Optionally compare to expected value x");
+    ADD_COMMAND(nrt,
+                " [x]            | Remove from tail of queue of numbers.  "
+                "Optionally compare to expected value x");
+    ADD_COMMAND(nsort,
+                "                | Sort queue of numbers in ascending order");
+    ADD_COMMAND(ndedup,
+                "                | Delete all numbers that occur more than "
+                "once in sorted queue of numbers");
+    ADD_COMMAND(nshow, "                | Show queue of numbers");
+    ADD_COMMAND(compress,
+                "                | Move the queue to the tail of the "
+                "front-coded store");
+    ADD_COMMAND(decompress,
+                "                | Move the front-coded store to the tail of "
+                "the queue");
+    ADD_COMMAND(prh,
+                " [str]          | Remove from head of front-coded store.  "
+                "Optionally compare to expected value str");
+    ADD_COMMAND(mpmc,
+                " p c [n]        | Run p producer threads inserting n strings "
+                "each into a lock-free queue, and c consumer threads removing "
+                "them (default: n == 100000)");
+    ADD_COMMAND(spsc,
+                " [n] [size]     | Hand n elements from one thread to another "
+                "through a wait-free ring of size slots, then through a list "
+                "behind a mutex (default: n == 1000000, size == 1024)");
     add_param("length", &string_length, "Maximum length of displayed string",
               NULL);
     add_param("malloc", &fail_probability, "Malloc failure probability percent",
               NULL);
     add_param("fail", &fail_limit,
               "Number of times allow queue operations to return false", NULL);
+    add_param("pool", &q_pool_enabled,
+              "Carve elements of new queues from a per-queue slab", NULL);
+    add_param("mid", &q_mid_enabled,
+              "Keep a middle cursor in new queues for constant-time dm", NULL);
+    add_param("intern", &q_intern_enabled,
+              "Share equal long strings of new pooled queues", NULL);
+    add_param("reclaim", &q_reclaim_enabled,
+              "Release freed queues on a background thread", NULL);
+    add_param("huge", &q_huge_enabled,
+              "Back new pooled queues with 2 MiB transparent huge pages", NULL);
+    add_param("stream", &stream_mode,
+              "Insert, remove and free without time limit or checks per batch",
+              NULL);
 }
 
 /* Signal handlers */
@@ -973,15 +2590,25 @@ static void queue_init()
 static bool queue_quit(int argc, char *argv[])
 {
     report(3, "Freeing queue");
-    if (lcnt > big_list_size)
+    size_t cnt = lcnt + snap_cnt + ncnt;
+    for (int i = 0; i < QUEUE_SLOTS; i++)
+        cnt += slots[i].size;
+    if (cnt > big_list_size)
         set_cautious_mode(false);
 
-    if (exception_setup(true))
-        q_free(l_meta.l);
+    if (exception_setup(!stream_mode)) {
+        qops->free(l_meta.l);
+        q_free(snap_l);
+        for (int i = 0; i < QUEUE_SLOTS; i++)
+            qops->free(slots[i].l);
+        nq_free(nq);
+        fc_free(packed);
+    }
     exception_cancel();
     set_cautious_mode(true);
+    q_reclaim_wait();
 
-    size_t bcnt = allocation_check();
+    size_t bcnt = allocation_check() + huge_regions();
     if (bcnt > 0) {
         report(1, "ERROR: Freed queue, but %lu blocks are still allocated",
                bcnt);
@@ -993,11 +2620,14 @@ static bool queue_quit(int argc, char *argv[])
 
 static void usage(char *cmd)
 {
-    printf("Usage: %s [-h] [-f IFILE][-v VLEVEL][-l LFILE]\n", cmd);
+    printf("Usage: %s [-h] [-f IFILE][-v VLEVEL][-l LFILE][-b BACKEND]\n",
+           cmd);
     printf("\t-h         Print this information\n");
     printf("\t-f IFILE   Read commands from IFILE\n");
     printf("\t-v VLEVEL  Set verbosity level\n");
     printf("\t-l LFILE   Echo results to LFILE\n");
+    printf("\t-b BACKEND Build the queue with BACKEND: list (default), "
+           "unrolled, ring or index\n");
     exit(0);
 }
 
@@ -1049,7 +2679,7 @@ int main(int argc, char *argv[])
     int level = 4;
     int c;
 
-    while ((c = getopt(argc, argv, "hv:f:l:")) != -1) {
+    while ((c = getopt(argc, argv, "hv:f:l:b:")) != -1) {
         switch (c) {
         case 'h':
             usage(argv[0]);
@@ -1074,6 +2704,13 @@ int main(int argc, char *argv[])
             buf[BUFSIZE - 1] = '\0';
             logfile_name = lbuf;
             break;
+        case 'b':
+            qops = find_backend(optarg);
+            if (!qops) {
+                fprintf(stderr, "Unknown backend '%s'\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
         default:
             printf("Unknown option '%c'\n", c);
             usage(argv[0]);
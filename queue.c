@@ -2,8 +2,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
 #include "harness.h"
+#include "intern.h"
 #include "queue.h"
+#include "reclaim.h"
+#include "slab.h"
 
 /* Notice: sometimes, Cppcheck would find the potential NULL pointer bugs,
  * but some of them cannot occur. You can suppress them by adding the
@@ -11,32 +15,426 @@
  *   cppcheck-suppress nullPointer
  */
 
+/*
+ * String storage of pooled queues, shared by a queue and its clones.
+ * Strings too long to be inlined live in the arena, unless they are too long
+ * for the arena as well, each behind a reference count so that clones can
+ * share it.  With interning, such strings are shared through the names
+ * table instead, whose copies count references of their own and come from
+ * the same arena.  The storage goes with the last pool using it.
+ */
+struct q_strs {
+    struct arena arena;
+    struct intern names;
+    size_t users;
+};
+
+/* Out-of-line string of a pooled queue, unless interned */
+struct q_str {
+    size_t refs;
+    char str[];
+};
+
+/*
+ * Element storage of a queue.  Elements carved from the slab point back here,
+ * so q_release_element can return them no matter which list they end up on.
+ */
+struct q_pool {
+    struct slab nodes;
+    /* NULL unless enabled */
+    struct q_strs *strs;
+    bool enabled;
+    bool interning;
+    /* The owning queue was freed while some of its elements were still out */
+    bool orphan;
+    /* q_free handed the queue to the reclaimer, which still has to run */
+    bool job_pending;
+};
+
+/* What q_new actually allocates: the descriptor plus state of queue.c */
+typedef struct {
+    queue_t q;
+    struct q_pool pool;
+    /*
+     * Middle cursor.  With n elements it sits on node n / 2 counting along
+     * next from the sentinel, whatever q.reversed says, or on the sentinel
+     * when the queue is empty.  Operations at either end move it
+     * by at most as many nodes as they add or remove.  It is only trusted
+     * while mid_gen matches q.gen, so any other change to the queue makes
+     * it stale, and q_delete_mid seeks it again.
+     */
+    struct list_head *mid;
+    unsigned long mid_gen;
+    bool track_mid;
+    /* What q_free hands to the reclaimer */
+    struct reclaim_job job;
+} queue_priv_t;
+
+static inline queue_priv_t *q_priv(struct list_head *head)
+{
+    return container_of(q_of(head), queue_priv_t, q);
+}
+
+static inline struct q_pool *q_pool_of(struct list_head *head)
+{
+    return &q_priv(head)->pool;
+}
+
+int q_pool_enabled = 1;
+int q_mid_enabled = 1;
+int q_intern_enabled = 0;
+int q_reclaim_enabled = 0;
+int q_huge_enabled = 0;
+
+/*
+ * Elements of live queues that the reclaimer found on freed ones.  Only the
+ * main thread touches a live queue's pool, so it releases them, see
+ * q_reclaim_wait.  Guarded by the reclaim lock.
+ */
+static LIST_HEAD(q_returns);
+
+static struct q_strs *q_strs_new(bool huge)
+{
+    struct q_strs *strs = malloc(sizeof(struct q_strs));
+    if (!strs)
+        return NULL;
+    arena_init(&strs->arena);
+    strs->arena.huge = huge;
+    intern_init(&strs->names, &strs->arena);
+    strs->users = 1;
+    return strs;
+}
+
+static void q_strs_put(struct q_strs *strs)
+{
+    if (!strs || --strs->users)
+        return;
+    intern_destroy(&strs->names);
+    arena_destroy(&strs->arena);
+    free(strs);
+}
+
+/*
+ * Create an empty queue.  A pooled one shares the string storage strs if
+ * given, else gets storage of its own.
+ */
+static queue_priv_t *q_create(bool pooled, bool interning, struct q_strs *strs)
+{
+    queue_priv_t *q = malloc(sizeof(queue_priv_t));
+    if (!q)
+        return NULL;
+    INIT_LIST_HEAD(&q->q.head);
+    q->q.size = 0;
+    q->q.gen = 0;
+    q->q.reversed = false;
+    q->mid = &q->q.head;
+    q->mid_gen = 0;
+    q->track_mid = q_mid_enabled;
+    slab_init(&q->pool.nodes, sizeof(element_t));
+    q->pool.nodes.huge = pooled && q_huge_enabled;
+    q->pool.strs = NULL;
+    q->pool.enabled = pooled;
+    q->pool.interning = pooled && interning;
+    q->pool.orphan = false;
+    q->pool.job_pending = false;
+    if (!pooled)
+        return q;
+
+    struct q_strs *own = strs ? NULL : q_strs_new(q_huge_enabled);
+    /* Keep the first insert as cheap as every other one */
+    if ((!strs && !own) || !slab_reserve(&q->pool.nodes)) {
+        q_strs_put(own);
+        free(q);
+        return NULL;
+    }
+    q->pool.strs = strs ? strs : own;
+    if (strs)
+        strs->users++;
+    return q;
+}
+
 /*
  * Create empty queue.
  * Return NULL if could not allocate space.
  */
 struct list_head *q_new()
 {
-    struct list_head *head = malloc(sizeof(struct list_head));
-    if (!head)
-        return NULL;
-    head->next = head;
-    head->prev = head;
-    return head;
+    queue_priv_t *q = q_create(q_pool_enabled, q_intern_enabled, NULL);
+    return q ? &q->q.head : NULL;
 }
 
-/* Free all storage used by queue */
-void q_free(struct list_head *l)
+/*
+ * Drop the pool and its queue once the queue is gone, no element is out and
+ * no job of the reclaimer, which lives in the queue, is still queued
+ */
+static void q_pool_put(struct q_pool *pool)
 {
-    if (!l)
+    if (!pool->orphan || pool->nodes.live || pool->job_pending)
         return;
+    slab_destroy(&pool->nodes);
+    q_strs_put(pool->strs);
+    free(container_of(pool, queue_priv_t, pool));
+}
+
+static inline bool q_mid_valid(queue_priv_t *p)
+{
+    return p->track_mid && p->mid_gen == p->q.gen;
+}
+
+/* Put the middle cursor on node size / 2 by walking from the head */
+static void q_mid_seek(queue_priv_t *p, size_t size)
+{
+    struct list_head *node = p->q.head.next;
+    for (size_t i = size / 2; i; i--)
+        node = node->next;
+    p->mid = node;
+}
+
+static void q_mid_move(queue_priv_t *p, long delta)
+{
+    for (; delta > 0; delta--)
+        p->mid = p->mid->next;
+    for (; delta < 0; delta++)
+        p->mid = p->mid->prev;
+}
+
+/* Record a change; the middle cursor stays trusted if mid_ok */
+static inline void q_touch(queue_priv_t *p, bool mid_ok)
+{
+    p->q.gen++;
+    if (mid_ok)
+        p->mid_gen = p->q.gen;
+}
+
+/* Bookkeeping after k elements were linked in at one end */
+static void q_added(struct list_head *head, size_t k, bool at_head)
+{
+    queue_priv_t *p = q_priv(head);
+    bool mid_ok = q_mid_valid(p);
+    size_t n = p->q.size;
+    if (mid_ok && !n) {
+        q_mid_seek(p, k);
+    } else if (mid_ok) {
+        /* Positions in the new list */
+        long cur = at_head ? n / 2 + k : n / 2;
+        q_mid_move(p, (long) ((n + k) / 2) - cur);
+    }
+    p->q.size += k;
+    q_touch(p, mid_ok);
+}
+
+/* Bookkeeping before k elements are unlinked from one end */
+static void q_removing(struct list_head *head, size_t k, bool at_head)
+{
+    queue_priv_t *p = q_priv(head);
+    bool mid_ok = q_mid_valid(p);
+    size_t n = p->q.size;
+    if (mid_ok && n == k) {
+        p->mid = head;
+    } else if (mid_ok) {
+        /* Positions in the old list, the target is never one of the k */
+        long target = at_head ? k + (n - k) / 2 : (n - k) / 2;
+        q_mid_move(p, target - (long) (n / 2));
+    }
+    p->q.size -= k;
+    q_touch(p, mid_ok);
+}
+
+/* Whether the head end of the queue, or else its tail end, is at head->next */
+static inline bool q_front(struct list_head *head, bool at_head)
+{
+    return at_head != q_of(head)->reversed;
+}
+
+static inline struct q_str *q_str_of(char *value)
+{
+    return (struct q_str *) (value - offsetof(struct q_str, str));
+}
+
+/* Bytes taken by a counted string of len characters */
+static inline size_t q_str_size(size_t len)
+{
+    return offsetof(struct q_str, str) + len + 1;
+}
+
+/* Whether e's string, neither inline nor interned, lives in the arena */
+static inline bool q_arena_value(const element_t *e)
+{
+    return e->pool && q_str_size(e->len) <= ARENA_MAX_ALLOC;
+}
+
+/* Whether e's string is a shared copy from its pool's names table */
+static inline bool q_interned(const element_t *e)
+{
+    return e->pool && e->pool->interning && e->value != e->inline_value;
+}
+
+/* Drop e's reference to its string, which goes with the last one */
+static inline void q_free_value(element_t *e)
+{
+    if (e->value == e->inline_value)
+        return;
+    if (!e->pool) {
+        free(e->value);
+        return;
+    }
+    if (q_interned(e)) {
+        intern_put(&e->pool->strs->names, e->value);
+        return;
+    }
+    struct q_str *str = q_str_of(e->value);
+    if (--str->refs)
+        return;
+    if (q_arena_value(e))
+        arena_free(&e->pool->strs->arena, str, q_str_size(e->len));
+    else
+        free(str);
+}
+
+static void q_release(element_t *e);
+
+/* Whether pool's strings are shared with clones */
+static inline bool q_strs_shared(const struct q_pool *pool)
+{
+    return pool->strs && pool->strs->users > 1;
+}
+
+/*
+ * Release the elements of a queue given up by q_free, and the queue itself
+ * once no element of its pool is out.  Runs with the reclaim lock held,
+ * on the reclaimer if on_worker.  Elements of other pools are left to the
+ * main thread, which may be using those pools.
+ */
+static void q_free_elements(queue_priv_t *p, bool on_worker)
+{
+    struct q_pool *pool = &p->pool;
+    bool shared = q_strs_shared(pool);
     element_t *entry;
     element_t *safe;
-    list_for_each_entry_safe (entry, safe, l, list) {
-        list_del_init(&entry->list);
+    size_t own = 0;
+    list_for_each_entry_safe (entry, safe, &p->q.head, list) {
+        if (entry->pool != pool) {
+            if (on_worker && entry->pool)
+                list_move_tail(&entry->list, &q_returns);
+            else
+                q_release(entry);
+            continue;
+        }
+        /*
+         * Our own nodes and strings are released together with the pool,
+         * and so is the names table, references and all, unless clones
+         * still use the strings
+         */
+        if (shared || (entry->value != entry->inline_value &&
+                       !q_interned(entry) && !q_arena_value(entry)))
+            q_free_value(entry);
+        own++;
+    }
+    pool->nodes.live -= own;
+    pool->job_pending = false;
+    q_pool_put(pool);
+}
+
+static void q_free_job(struct reclaim_job *job)
+{
+    q_free_elements(container_of(job, queue_priv_t, job), true);
+}
+
+/*
+ * Release the elements the reclaimer handed back.  While it is busy, they
+ * are left for a later call rather than waiting for it, unless wait is set
+ * because the caller needs every element of its pool accounted for.
+ */
+static void q_take_returns(bool wait)
+{
+    LIST_HEAD(returns);
+    if (wait)
+        reclaim_lock();
+    else if (!reclaim_trylock())
+        return;
+    list_splice_init(&q_returns, &returns);
+    reclaim_unlock();
+    element_t *entry, *safe;
+    list_for_each_entry_safe (entry, safe, &returns, list)
         q_release_element(entry);
+}
+
+/*
+ * Free all storage used by queue.
+ * From here on, the reclaimer may be working on the pool, so elements still
+ * out are released under the reclaim lock.  With q_reclaim_enabled, the
+ * list is detached as a whole and left to the reclaimer, unless clones that
+ * the main thread keeps using share its strings.
+ */
+void q_free(struct list_head *l)
+{
+    if (!l)
+        return;
+    queue_priv_t *p = q_priv(l);
+    q_take_returns(false);
+    /*
+     * Jobs only touch the pools of queues already freed, so this needs no
+     * lock, and freeing does not wait for the reclaimer to finish a job
+     */
+    p->pool.orphan = true;
+    if (q_reclaim_enabled && !q_strs_shared(&p->pool)) {
+        p->job.run = q_free_job;
+        p->pool.job_pending = true;
+        if (reclaim_submit(&p->job))
+            return;
+        p->pool.job_pending = false;
+    }
+    reclaim_lock();
+    q_free_elements(p, false);
+    reclaim_unlock();
+}
+
+/* Wait for the reclaimer, then release what it handed back */
+void q_reclaim_wait()
+{
+    reclaim_wait();
+    q_take_returns(true);
+}
+
+static element_t *q_new_element(struct list_head *head, char *s)
+{
+    size_t len = strlen(s);
+    if (len >= UINT32_MAX)
+        return NULL;
+    struct q_pool *pool = q_pool_of(head);
+    element_t *n =
+        pool->enabled ? slab_alloc(&pool->nodes) : malloc(sizeof(element_t));
+    if (!n)
+        return NULL;
+    n->pool = pool->enabled ? pool : NULL;
+    n->key = q_key(s, len);
+    n->len = len;
+    if (len < Q_INLINE_LEN) {
+        memcpy(n->inline_value, s, len + 1);
+        n->value = n->inline_value;
+        return n;
+    }
+    if (pool->interning) {
+        n->value = intern_get(&pool->strs->names, s, len);
+    } else if (!n->pool) {
+        n->value = malloc(len + 1);
+    } else {
+        struct q_str *str = q_arena_value(n)
+                                ? arena_alloc(&pool->strs->arena,
+                                              q_str_size(len))
+                                : malloc(q_str_size(len));
+        n->value = str ? str->str : NULL;
+        if (str)
+            str->refs = 1;
     }
-    free(l);
+    if (!n->value) {
+        n->value = n->inline_value;
+        q_release_element(n);
+        return NULL;
+    }
+    if (!pool->interning)
+        memcpy(n->value, s, len + 1);
+    return n;
 }
 
 /*
@@ -52,16 +450,15 @@ bool q_insert_head(struct list_head *head, char *s)
         return false;
     if (!s)
         return false;
-    char *tmp = strdup(s);
-    if (!tmp)
-        return false;
-    element_t *n = malloc(sizeof(element_t));
-    if (!n) {
-        free(tmp);
+    element_t *n = q_new_element(head, s);
+    if (!n)
         return false;
-    }
-    n->value = tmp;
-    list_add(&n->list, head);
+    bool front = q_front(head, true);
+    if (front)
+        list_add(&n->list, head);
+    else
+        list_add_tail(&n->list, head);
+    q_added(head, 1, front);
     return true;
 }
 
@@ -78,19 +475,207 @@ bool q_insert_tail(struct list_head *head, char *s)
         return false;
     if (!s)
         return false;
-    char *tmp = strdup(s);
-    if (!tmp)
+    element_t *n = q_new_element(head, s);
+    if (!n)
         return false;
-    element_t *n = malloc(sizeof(element_t));
-    if (!n) {
-        free(tmp);
+    bool front = q_front(head, false);
+    if (front)
+        list_add(&n->list, head);
+    else
+        list_add_tail(&n->list, head);
+    q_added(head, 1, front);
+    return true;
+}
+
+/* Release every element on list, which need not be a queue */
+static size_t q_release_all(struct list_head *list)
+{
+    element_t *entry, *safe;
+    size_t n = 0;
+    list_for_each_entry_safe (entry, safe, list, list) {
+        q_release_element(entry);
+        n++;
+    }
+    return n;
+}
+
+/*
+ * All elements are built off the list first and spliced in at once, so on
+ * failure the queue is left untouched.  Either way, the element inserted
+ * last ends up nearest the end it went in at.
+ */
+static bool q_insert_n(struct list_head *head,
+                       char **s,
+                       size_t n,
+                       bool at_head)
+{
+    if (!head || !s)
         return false;
+    bool front = q_front(head, at_head);
+    LIST_HEAD(batch);
+    for (size_t i = 0; i < n; i++) {
+        element_t *e = s[i] ? q_new_element(head, s[i]) : NULL;
+        if (!e) {
+            q_release_all(&batch);
+            return false;
+        }
+        if (front)
+            list_add(&e->list, &batch);
+        else
+            list_add_tail(&e->list, &batch);
     }
-    n->value = tmp;
-    list_add_tail(&n->list, head);
+    if (front)
+        list_splice(&batch, head);
+    else
+        list_splice_tail(&batch, head);
+    q_added(head, n, front);
     return true;
 }
 
+/*
+ * Attempt to insert n elements at head of queue, as if by calling
+ * q_insert_head for s[0], s[1], ..., s[n - 1] in turn.
+ */
+bool q_insert_head_n(struct list_head *head, char **s, size_t n)
+{
+    return q_insert_n(head, s, n, true);
+}
+
+/*
+ * Attempt to insert n elements at tail of queue, as if by calling
+ * q_insert_tail for s[0], s[1], ..., s[n - 1] in turn.
+ * Other attribute is as same as q_insert_head_n.
+ */
+bool q_insert_tail_n(struct list_head *head, char **s, size_t n)
+{
+    return q_insert_n(head, s, n, false);
+}
+
+/*
+ * Create a queue holding the same strings in the same order.
+ * Elements of the queue's own pool are copied as they are, taking one more
+ * reference to their string; the strings themselves are never written, so
+ * each queue simply drops its references on its own.  Elements of other
+ * pools get a copy of their string.
+ */
+struct list_head *q_clone(struct list_head *head)
+{
+    if (!head)
+        return NULL;
+    struct q_pool *from = q_pool_of(head);
+    queue_priv_t *q = q_create(from->enabled, from->interning, from->strs);
+    if (!q)
+        return NULL;
+    struct list_head *l = &q->q.head;
+    for (struct list_head *node = q_next(head, head); node != head;
+         node = q_next(head, node)) {
+        element_t *e = list_entry(node, element_t, list);
+        element_t *c;
+        if (e->pool && e->pool == from) {
+            c = slab_alloc(&q->pool.nodes);
+            if (!c)
+                goto fail;
+            *c = *e;
+            c->pool = &q->pool;
+            if (e->value == e->inline_value)
+                c->value = c->inline_value;
+            else if (from->interning)
+                intern_hold(e->value);
+            else
+                q_str_of(e->value)->refs++;
+        } else {
+            c = q_new_element(l, e->value);
+            if (!c)
+                goto fail;
+        }
+        list_add_tail(&c->list, l);
+        q->q.size++;
+    }
+    /* The middle cursor is sought on first use */
+    q_touch(q, false);
+    return l;
+
+fail:
+    q_free(l);
+    return NULL;
+}
+
+static element_t *q_take(struct list_head *head, size_t *len, bool at_head)
+{
+    if (!head)
+        return NULL;
+    if (list_empty(head))
+        return NULL;
+    bool front = q_front(head, at_head);
+    element_t *tmp = front ? list_first_entry(head, element_t, list)
+                           : list_last_entry(head, element_t, list);
+    q_removing(head, 1, front);
+    list_del_init(&tmp->list);
+    if (len)
+        *len = tmp->len;
+    return tmp;
+}
+
+/*
+ * Unlink the element at head of queue and hand it over as is: the caller
+ * gets value without any copy, and its length if len is non-NULL.
+ * Return NULL if queue is NULL or empty.
+ */
+element_t *q_take_head(struct list_head *head, size_t *len)
+{
+    return q_take(head, len, true);
+}
+
+/*
+ * Unlink the element at tail of queue and hand it over as is.
+ * Other attribute is as same as q_take_head.
+ */
+element_t *q_take_tail(struct list_head *head, size_t *len)
+{
+    return q_take(head, len, false);
+}
+
+/*
+ * Unlink up to k elements from head of queue into vec, in queue order.
+ * The run is cut out with a single relink, so the list nodes of the
+ * returned elements are left stale rather than reinitialized.
+ * Return the number of elements stored.
+ */
+size_t q_take_head_n(struct list_head *head, element_t **vec, size_t k)
+{
+    if (!head || !vec)
+        return 0;
+    size_t n = 0;
+    struct list_head *node = q_next(head, head);
+    for (; n < k && node != head; node = q_next(head, node))
+        vec[n++] = list_entry(node, element_t, list);
+    if (!n)
+        return 0;
+    bool front = q_front(head, true);
+    q_removing(head, n, front);
+    if (front) {
+        head->next = node;
+        node->prev = head;
+    } else {
+        head->prev = node;
+        node->next = head;
+    }
+    return n;
+}
+
+/* Copy the value of e to sp, truncated to bufsize - 1 characters */
+static void q_copy_value(const element_t *e,
+                         size_t len,
+                         char *sp,
+                         size_t bufsize)
+{
+    if (!sp)
+        return;
+    len = len > bufsize - 1 ? bufsize - 1 : len;
+    memcpy(sp, e->value, len);
+    sp[len] = '\0';
+}
+
 /*
  * Attempt to remove element from head of queue.
  * Return target element.
@@ -107,18 +692,10 @@ bool q_insert_tail(struct list_head *head, char *s)
  */
 element_t *q_remove_head(struct list_head *head, char *sp, size_t bufsize)
 {
-    if (!head)
-        return NULL;
-    if (list_empty(head))
-        return NULL;
-    element_t *tmp = list_first_entry(head, element_t, list);
-    list_del_init(&tmp->list);
-    if (!sp)
-        return tmp;
-    size_t len = strlen(tmp->value);
-    len = len > bufsize - 1 ? bufsize - 1 : len;
-    strncpy(sp, tmp->value, len);
-    sp[len] = '\0';
+    size_t len = 0;
+    element_t *tmp = q_take_head(head, sp ? &len : NULL);
+    if (tmp)
+        q_copy_value(tmp, len, sp, bufsize);
     return tmp;
 }
 
@@ -128,49 +705,172 @@ element_t *q_remove_head(struct list_head *head, char *sp, size_t bufsize)
  */
 element_t *q_remove_tail(struct list_head *head, char *sp, size_t bufsize)
 {
-    if (!head)
-        return NULL;
-    if (list_empty(head))
-        return NULL;
-    element_t *tmp = list_last_entry(head, element_t, list);
-    list_del_init(&tmp->list);
-    if (!sp)
-        return tmp;
-    size_t len = strlen(tmp->value);
-    len = len > bufsize - 1 ? bufsize - 1 : len;
-    strncpy(sp, tmp->value, len);
-    sp[len] = '\0';
+    size_t len = 0;
+    element_t *tmp = q_take_tail(head, sp ? &len : NULL);
+    if (tmp)
+        q_copy_value(tmp, len, sp, bufsize);
     return tmp;
 }
 
 /*
- * WARN: This is for external usage, don't modify it
  * Attempt to release element.
+ * Pooled elements go back on their queue's free list; the pool itself is
+ * dropped here if its queue has already been freed.
  */
 void q_release_element(element_t *e)
 {
-    free(e->value);
-    free(e);
+    if (e->pool && e->pool->orphan) {
+        reclaim_lock();
+        q_release(e);
+        reclaim_unlock();
+        return;
+    }
+    q_release(e);
+}
+
+/* Release e, with the reclaim lock held if its pool is an orphan */
+static void q_release(element_t *e)
+{
+    struct q_pool *pool = e->pool;
+    q_free_value(e);
+    if (!pool) {
+        free(e);
+        return;
+    }
+    slab_free(&pool->nodes, e);
+    q_pool_put(pool);
+}
+
+/* Whether e's string is one of pool's arena strings; sets *size if so */
+static inline bool q_own_arena_value(struct q_pool *pool,
+                                     element_t *e,
+                                     size_t *size)
+{
+    if (e->pool != pool || e->value == e->inline_value || q_interned(e))
+        return false;
+    *size = q_str_size(e->len);
+    return q_arena_value(e);
+}
+
+/*
+ * Move the arena strings of the queue into one fresh block, in list order.
+ * Refuse if removed elements still hold some of them, since those could not
+ * be updated.  A pending reverse is applied first, so that a walk in queue
+ * order walks forward through the block.
+ */
+bool q_compact_values(struct list_head *head)
+{
+    if (!head)
+        return false;
+    q_take_returns(true);
+    q_straighten(head);
+    struct q_pool *pool = q_pool_of(head);
+    if (!pool->strs)
+        return true;
+    if (q_strs_shared(pool))
+        return false;
+    element_t *e;
+    size_t size, total = 0;
+    list_for_each_entry (e, head, list) {
+        if (q_own_arena_value(pool, e, &size))
+            total += arena_round(size);
+    }
+    if (total != pool->strs->arena.used)
+        return false;
+
+    struct arena fresh;
+    arena_init(&fresh);
+    fresh.huge = pool->strs->arena.huge;
+    if (total && !arena_reserve(&fresh, total))
+        return false;
+    list_for_each_entry (e, head, list) {
+        if (!q_own_arena_value(pool, e, &size))
+            continue;
+        struct q_str *p = arena_alloc(&fresh, size);
+        memcpy(p, q_str_of(e->value), size);
+        e->value = p->str;
+    }
+    arena_destroy(&pool->strs->arena);
+    pool->strs->arena = fresh;
+    q_touch(q_priv(head), q_mid_valid(q_priv(head)));
+    return true;
+}
+
+/*
+ * Copy the elements of the queue's own pool into a fresh slab in queue
+ * order, then pack their strings with q_compact_values.  Elements of other
+ * pools stay where they are.  Refuse if some element of the pool is not on
+ * the list, since it would be left pointing into the old slab.
+ */
+bool q_compact(struct list_head *head)
+{
+    if (!head)
+        return false;
+    q_take_returns(true);
+    q_straighten(head);
+    queue_priv_t *p = q_priv(head);
+    struct q_pool *pool = &p->pool;
+    if (!pool->enabled)
+        return true;
+    element_t *e;
+    size_t own = 0;
+    list_for_each_entry (e, head, list)
+        own += e->pool == pool;
+    if (own != pool->nodes.live)
+        return false;
+
+    struct slab fresh;
+    slab_init(&fresh, sizeof(element_t));
+    fresh.huge = pool->nodes.huge;
+    if (!slab_reserve_n(&fresh, own)) {
+        slab_destroy(&fresh);
+        return false;
+    }
+    for (struct list_head *node = head->next; node != head;
+         node = node->next) {
+        e = list_entry(node, element_t, list);
+        if (e->pool != pool)
+            continue;
+        element_t *n = slab_alloc(&fresh);
+        *n = *e;
+        if (e->value == e->inline_value)
+            n->value = n->inline_value;
+        n->list.prev->next = &n->list;
+        n->list.next->prev = &n->list;
+        if (p->mid == node)
+            p->mid = &n->list;
+        node = &n->list;
+    }
+    slab_destroy(&pool->nodes);
+    pool->nodes = fresh;
+    q_touch(p, q_mid_valid(p));
+
+    /* Strings shared with clones or interned stay where they are */
+    q_compact_values(head);
+    return true;
 }
 
 /*
  * Return number of elements in queue.
  * Return 0 if q is NULL or empty
  */
-int q_size(struct list_head *head)
+size_t q_size(struct list_head *head)
 {
     if (!head)
         return 0;
+    return q_of(head)->size;
+}
 
-    int len = 0;
-    struct list_head *li;
 
-    list_for_each (li, head)
-        len++;
-    return len;
+/* Whether a and b hold equal strings */
+static inline bool q_equal(const element_t *a, const element_t *b)
+{
+    /* Interned strings of one table are equal exactly when they are shared */
+    if (q_interned(a) && q_interned(b) && a->pool->strs == b->pool->strs)
+        return a->value == b->value;
+    return q_cmp(a, b) == 0;
 }
 
-
 /*
  * Delete the middle node in list.
  * The middle node of a linked list of size n is the
@@ -186,15 +886,36 @@ bool q_delete_mid(struct list_head *head)
         return false;
     if (list_empty(head))
         return false;
-    element_t *front = list_entry(head->next, element_t, list),
-              *back = list_entry(head->prev, element_t, list);
-    for (; front != back && front->list.next != &back->list;
-         front = list_entry(front->list.next, element_t, list),
-         back = list_entry(back->list.prev, element_t, list)) {
+    queue_priv_t *p = q_priv(head);
+    size_t n = p->q.size;
+    struct list_head *mid;
+    if (p->track_mid) {
+        if (!q_mid_valid(p))
+            q_mid_seek(p, n);
+        mid = p->mid;
+        if (p->q.reversed && !(n & 1)) {
+            /*
+             * Counting from the tail end, the cursor's predecessor is node
+             * n / 2, and the cursor is the right one for what is left
+             */
+            mid = mid->prev;
+        } else {
+            /* Node n / 2 of the shorter list is a neighbour of the deleted */
+            p->mid = n == 1 ? head : (n & 1) ? mid->next : mid->prev;
+        }
+    } else {
+        struct list_head *front = q_next(head, head),
+                         *back = q_prev(head, head);
+        for (; front != back && q_next(head, front) != back;
+             front = q_next(head, front), back = q_prev(head, back)) {
+        }
+        mid = back;
     }
 
-    list_del_init(&back->list);
-    q_release_element(back);
+    list_del_init(mid);
+    q_release_element(list_entry(mid, element_t, list));
+    p->q.size--;
+    q_touch(p, p->track_mid);
     return true;
 }
 
@@ -217,13 +938,14 @@ bool q_delete_dup(struct list_head *head)
         return false;
     if (list_is_singular(head))
         return true;
-    struct list_head *rec = q_new();
+    LIST_HEAD(dup);
+    struct list_head *rec = &dup;
     struct list_head *front = head->next;
     struct list_head *back = head->next->next;
     while (front != head && back != head) {
         element_t *back_entry = list_entry(back, element_t, list);
         element_t *front_entry = list_entry(front, element_t, list);
-        while (strcmp(front_entry->value, back_entry->value) == 0) {
+        while (q_equal(front_entry, back_entry)) {
             back = back->next;
             if (back == head)
                 break;
@@ -244,7 +966,49 @@ bool q_delete_dup(struct list_head *head)
         front = back;
         back = back->next;
     }
-    q_free(rec);
+    q_of(head)->size -= q_release_all(rec);
+    q_of(head)->gen++;
+    return true;
+}
+
+/*
+ * One pass with an open-addressing table of the elements seen so far, keyed
+ * by string.  A slot whose low bit is set holds a string already known to
+ * repeat, whose first element has been moved to the dup list along with the
+ * others.  Elements are only released at the end, so slots stay valid.
+ */
+bool q_delete_dup_unsorted(struct list_head *head)
+{
+    if (!head || list_empty(head))
+        return false;
+    size_t cap = 16;
+    while (cap < 2 * q_of(head)->size)
+        cap <<= 1;
+    uintptr_t *slots = malloc(cap * sizeof(*slots));
+    if (!slots)
+        return false;
+    memset(slots, 0, cap * sizeof(*slots));
+
+    LIST_HEAD(dup);
+    element_t *e, *safe;
+    list_for_each_entry_safe (e, safe, head, list) {
+        size_t i = intern_hash(e->value, e->len) & (cap - 1);
+        while (slots[i] &&
+               !q_equal((element_t *) (slots[i] & ~(uintptr_t) 1), e))
+            i = (i + 1) & (cap - 1);
+        if (!slots[i]) {
+            slots[i] = (uintptr_t) e;
+            continue;
+        }
+        if (!(slots[i] & 1)) {
+            list_move_tail(&((element_t *) slots[i])->list, &dup);
+            slots[i] |= 1;
+        }
+        list_move_tail(&e->list, &dup);
+    }
+    free(slots);
+    q_of(head)->size -= q_release_all(&dup);
+    q_of(head)->gen++;
     return true;
 }
 
@@ -260,7 +1024,12 @@ void q_swap(struct list_head *head)
         return;
     if (list_is_singular(head))
         return;
-    struct list_head *walk = head;
+    /*
+     * Pairs are the same seen from either end, except that with an odd count
+     * the one left alone is at the tail end of the queue
+     */
+    struct list_head *walk =
+        q_of(head)->reversed && (q_of(head)->size & 1) ? head->next : head;
     while (walk->next != head && walk->next->next != head) {
         struct list_head *front = walk->next;
         struct list_head *back = walk->next->next;
@@ -270,6 +1039,7 @@ void q_swap(struct list_head *head)
         list_add(back, walk);
         walk = walk->next->next;
     }
+    q_of(head)->gen++;
 }
 
 /*
@@ -287,6 +1057,23 @@ void q_reverse(struct list_head *head)
         return;
     if (list_is_singular(head))
         return;
+    queue_priv_t *p = q_priv(head);
+    p->q.reversed = !p->q.reversed;
+    q_touch(p, q_mid_valid(p));
+}
+
+/*
+ * Relink the nodes the other way round and flip q.reversed to match, which
+ * leaves the queue order as it was.
+ */
+static void q_flip(queue_priv_t *p)
+{
+    /* With an even count, the cursor's predecessor becomes node n / 2 */
+    bool mid_ok = q_mid_valid(p);
+    if (mid_ok && !(p->q.size & 1))
+        p->mid = p->mid->prev;
+
+    struct list_head *head = &p->q.head;
     struct list_head *curr = head;
     struct list_head *prev = head->prev;
     struct list_head *next = head->next;
@@ -297,7 +1084,122 @@ void q_reverse(struct list_head *head)
         curr = next;
         next = next->next;
     } while (curr != head);
+    p->q.reversed = !p->q.reversed;
+    q_touch(p, mid_ok);
+}
+
+/*
+ * Apply a pending reverse to the links, so that list.h walks see the queue
+ * in order again.
+ */
+void q_straighten(struct list_head *head)
+{
+    if (!head || !q_of(head)->reversed)
+        return;
+    q_flip(q_priv(head));
+}
+
+/*
+ * Make dst and src run the same way round, so that nodes of one can be
+ * linked into the other as they are.  An empty queue just takes the other's
+ * direction; otherwise the shorter one is relinked.
+ */
+static void q_align(queue_priv_t *dst, queue_priv_t *src)
+{
+    if (dst->q.reversed == src->q.reversed)
+        return;
+    if (!dst->q.size)
+        dst->q.reversed = src->q.reversed;
+    else if (!src->q.size)
+        src->q.reversed = dst->q.reversed;
+    else
+        q_flip(src->q.size <= dst->q.size ? src : dst);
 }
+
+/* Move the nodes of list, which runs the same way as head, to its tail end */
+static void q_splice_tail(struct list_head *head, struct list_head *list)
+{
+    if (q_front(head, false))
+        list_splice_init(list, head);
+    else
+        list_splice_tail_init(list, head);
+}
+
+/*
+ * Node i along next from the sentinel, 0 <= i < size.  The walk starts from
+ * the sentinel, going either way, or from the middle cursor, whichever is
+ * closest.
+ */
+static struct list_head *q_node_at(queue_priv_t *p, size_t i)
+{
+    size_t n = p->q.size;
+    struct list_head *node = &p->q.head;
+    long steps = i < n - i ? (long) i + 1 : -(long) (n - i);
+    long from_mid = (long) i - (long) (n / 2);
+    if (q_mid_valid(p) && labs(from_mid) < labs(steps)) {
+        node = p->mid;
+        steps = from_mid;
+    }
+    for (; steps > 0; steps--)
+        node = node->next;
+    for (; steps < 0; steps++)
+        node = node->prev;
+    return node;
+}
+
+bool q_concat(struct list_head *dst, struct list_head *src)
+{
+    if (!dst || !src || dst == src)
+        return false;
+    queue_priv_t *d = q_priv(dst);
+    queue_priv_t *s = q_priv(src);
+    if (!s->q.size)
+        return true;
+    q_align(d, s);
+    /* Into an empty queue, the nodes keep their positions */
+    bool mid_ok = !d->q.size && d->track_mid && q_mid_valid(s);
+    if (mid_ok)
+        d->mid = s->mid;
+    q_splice_tail(dst, src);
+    d->q.size += s->q.size;
+    s->q.size = 0;
+    s->mid = src;
+    q_touch(d, mid_ok);
+    q_touch(s, true);
+    return true;
+}
+
+bool q_split(struct list_head *src, size_t n, struct list_head *dst)
+{
+    if (!src || !dst || src == dst)
+        return false;
+    queue_priv_t *s = q_priv(src);
+    queue_priv_t *d = q_priv(dst);
+    if (n >= s->q.size)
+        return true;
+    if (!n)
+        return q_concat(dst, src);
+    size_t k = s->q.size - n;
+    q_align(d, s);
+
+    /* The k nodes to move are at the far end along next, unless reversed */
+    LIST_HEAD(moved);
+    if (!s->q.reversed) {
+        LIST_HEAD(kept);
+        list_cut_position(&kept, src, q_node_at(s, n - 1));
+        list_splice_init(src, &moved);
+        list_splice_init(&kept, src);
+    } else {
+        list_cut_position(&moved, src, q_node_at(s, k - 1));
+    }
+    q_splice_tail(dst, &moved);
+    s->q.size = n;
+    d->q.size += k;
+    q_touch(s, false);
+    q_touch(d, false);
+    return true;
+}
+
 void my_merge(struct list_head **li,
               struct list_head **mi,
               struct list_head **ri)
@@ -314,7 +1216,7 @@ void my_merge(struct list_head **li,
     element_t *l_entry = list_entry(l_start, element_t, list);
     element_t *r_entry = list_entry(r_start, element_t, list);
     while (true) {
-        if (strcmp(l_entry->value, r_entry->value) > 0) {
+        if (q_cmp(l_entry, r_entry) > 0) {
             struct list_head *next_r_start = r_start->next;
             list_del_init(r_start);
             list_add(r_start, walk);
@@ -364,5 +1266,11 @@ void q_sort(struct list_head *head)
 {
     if (!head)
         return;
+    /*
+     * A pending reverse is applied first: equal strings keep the order they
+     * had, so the sort is stable however many reverses came before it
+     */
+    q_straighten(head);
     merge_sort(&head->next, &head->prev);
+    q_of(head)->gen++;
 }
@@ -10,17 +10,140 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include "list.h"
 
+/* Per-queue node storage, private to queue.c */
+struct q_pool;
+
+/*
+ * Strings shorter than this are stored inside the element itself.
+ * Chosen so that an element fills exactly one 64-byte cache line.
+ */
+#define Q_INLINE_LEN 20
+
+/* Number of leading bytes of a string cached in element_t.key */
+#define Q_KEY_LEN 8
+
 /* Linked list element */
 typedef struct {
     /* Pointer to array holding string.
-     * This array needs to be explicitly allocated and freed
+     * Points at inline_value for short strings, otherwise to an array that
+     * needs to be explicitly allocated and freed
      */
     char *value;
     struct list_head list;
+    /* Pool the element was carved from, NULL if it was malloc'ed alone */
+    struct q_pool *pool;
+    /*
+     * First Q_KEY_LEN bytes of the string packed big-endian, zero-padded
+     * past its end, so that comparing keys orders strings as strcmp does.
+     */
+    uint64_t key;
+    /* Length of the string, recorded at insertion */
+    uint32_t len;
+    char inline_value[Q_INLINE_LEN];
 } element_t;
 
+/* Key of string s of length len, as cached in element_t.key */
+static inline uint64_t q_key(const char *s, size_t len)
+{
+    uint64_t key = 0;
+    for (size_t i = 0; i < Q_KEY_LEN; i++)
+        key = key << 8 | (i < len ? (unsigned char) s[i] : 0);
+    return key;
+}
+
+/*
+ * Compare the strings of a and b as strcmp does.  Most comparisons are
+ * settled by the cached keys without reading either string.
+ */
+static inline int q_cmp(const element_t *a, const element_t *b)
+{
+    if (a->key != b->key)
+        return a->key < b->key ? -1 : 1;
+    /* Equal keys with a null last byte: both strings have ended already */
+    if (!(a->key & 0xff))
+        return 0;
+    return strcmp(a->value + Q_KEY_LEN, b->value + Q_KEY_LEN);
+}
+
+/*
+ * Nonzero if queues created by q_new carve their elements from a per-queue
+ * slab instead of calling malloc once per element.
+ */
+extern int q_pool_enabled;
+
+/*
+ * Nonzero if queues created by q_new keep a cursor on their middle node, so
+ * that q_delete_mid does not have to search for it.
+ */
+extern int q_mid_enabled;
+
+/*
+ * Nonzero if pooled queues created by q_new intern the strings too long to
+ * be inlined: equal strings share one reference-counted copy, and
+ * q_delete_dup tells them apart by address.
+ */
+extern int q_intern_enabled;
+
+/*
+ * Nonzero if q_free hands the list over to a background thread instead of
+ * releasing it before returning.  q_reclaim_wait waits for that thread.
+ */
+extern int q_reclaim_enabled;
+
+/*
+ * Nonzero if pooled queues created by q_new take their elements and strings
+ * from 2 MiB regions backed by transparent huge pages, see hugepage.h.
+ * Where those are unavailable, the queues fall back to malloc.
+ */
+extern int q_huge_enabled;
+
+/*
+ * Queue descriptor.
+ * q_new hands out &q->head, so code that only deals in struct list_head
+ * keeps working, once q_straighten has applied any pending reverse; q_of
+ * gets back to the descriptor from such a head.
+ */
+typedef struct {
+    /* Sentinel of the element list, must stay the first member */
+    struct list_head head;
+    /* Number of elements, maintained by every operation */
+    size_t size;
+    /* Bumped by every operation that changes contents or order */
+    unsigned long gen;
+    /*
+     * Set by q_reverse instead of relinking: the queue then runs from
+     * head.prev to head.next.  q_straighten relinks and clears it.
+     */
+    bool reversed;
+} queue_t;
+
+/* Descriptor of a queue created by q_new */
+static inline queue_t *q_of(struct list_head *head)
+{
+    return list_entry(head, queue_t, head);
+}
+
+/*
+ * Node after pos in queue order, honoring a pending reverse.  From the
+ * sentinel, this is the first node; the sentinel comes after the last.
+ */
+static inline struct list_head *q_next(struct list_head *head,
+                                       struct list_head *pos)
+{
+    return q_of(head)->reversed ? pos->prev : pos->next;
+}
+
+/* Node before pos in queue order, as q_next */
+static inline struct list_head *q_prev(struct list_head *head,
+                                       struct list_head *pos)
+{
+    return q_of(head)->reversed ? pos->next : pos->prev;
+}
+
 /* Operations on queue */
 
 /*
@@ -35,11 +158,17 @@ struct list_head *q_new();
  */
 void q_free(struct list_head *head);
 
+/*
+ * Wait until the storage of every queue freed so far has been released,
+ * which is only pending with q_reclaim_enabled.
+ */
+void q_reclaim_wait();
+
 /*
  * Attempt to insert element at head of queue.
  * Return true if successful.
  * Return false if q is NULL or could not allocate space.
- * Argument s points to the string to be stored.
+ * Argument s points to the string to be stored, shorter than UINT32_MAX.
  * The function must explicitly allocate space and copy the string into it.
  */
 bool q_insert_head(struct list_head *head, char *s);
@@ -53,6 +182,51 @@ bool q_insert_head(struct list_head *head, char *s);
  */
 bool q_insert_tail(struct list_head *head, char *s);
 
+/*
+ * Attempt to insert n elements at head of queue, with the same result as
+ * calling q_insert_head for s[0], s[1], ..., s[n - 1] in turn.
+ * Return true if successful.
+ * Return false if q is NULL or could not allocate space, in which case the
+ * queue is left unchanged.
+ */
+bool q_insert_head_n(struct list_head *head, char **s, size_t n);
+
+/*
+ * Attempt to insert n elements at tail of queue, with the same result as
+ * calling q_insert_tail for s[0], s[1], ..., s[n - 1] in turn.
+ * Other attribute is as same as q_insert_head_n.
+ */
+bool q_insert_tail_n(struct list_head *head, char **s, size_t n);
+
+/*
+ * Create a queue holding the same strings as head, in the same order.
+ * The two are independent, but share the storage of the strings, which
+ * goes once neither queue holds them any more.  Cloning thus costs one
+ * element per element, and no string copies.
+ * Return NULL if q is NULL or could not allocate space.
+ */
+struct list_head *q_clone(struct list_head *head);
+
+/*
+ * Move all elements of src to the tail of dst, in order, leaving src empty.
+ * Elements keep the storage of the queue they were inserted in, which stays
+ * allocated until the last of them is released.
+ * Runs in constant time, unless one of the queues has a pending reverse that
+ * the other lacks, in which case the shorter one is relinked first.
+ * Return false if either queue is NULL or both are the same queue.
+ */
+bool q_concat(struct list_head *dst, struct list_head *src);
+
+/*
+ * Move the elements of src from index n on, counting from 0 at the head, to
+ * the tail of dst, in order, so that src keeps its first n elements.
+ * Nothing moves if src holds n elements or fewer.
+ * The cut is found by walking from the head, the tail or the middle cursor,
+ * whichever is closest, so splitting near either end or near the middle
+ * takes constant time.  Other attribute is as same as q_concat.
+ */
+bool q_split(struct list_head *src, size_t n, struct list_head *dst);
+
 /*
  * Attempt to remove element from head of queue.
  * Return target element.
@@ -75,16 +249,61 @@ element_t *q_remove_head(struct list_head *head, char *sp, size_t bufsize);
  */
 element_t *q_remove_tail(struct list_head *head, char *sp, size_t bufsize);
 
+/*
+ * Remove element from head of queue without copying its string.
+ * Return target element, whose value stays valid until it is released.
+ * Return NULL if queue is NULL or empty.
+ * If len is non-NULL and an element is removed, store the length of its
+ * value in *len.
+ */
+element_t *q_take_head(struct list_head *head, size_t *len);
+
+/*
+ * Remove element from tail of queue without copying its string.
+ * Other attribute is as same as q_take_head.
+ */
+element_t *q_take_tail(struct list_head *head, size_t *len);
+
+/*
+ * Remove up to k elements from head of queue into vec, in queue order.
+ * The list nodes of the removed elements are not reinitialized.
+ * Return the number of elements removed.
+ * Return 0 if queue is NULL or empty.
+ */
+size_t q_take_head_n(struct list_head *head, element_t **vec, size_t k);
+
 /*
  * Attempt to release element.
  */
 void q_release_element(element_t *e);
 
+/*
+ * Rewrite the out-of-line strings of the queue into one contiguous block in
+ * queue order, dropping the holes left by earlier removals.
+ * Return true if successful.
+ * Return false if q is NULL, if removed elements or clones still hold some of
+ * the strings, if they are interned, or if the new block could not be
+ * allocated.
+ */
+bool q_compact_values(struct list_head *head);
+
+/*
+ * Move the elements of the queue into fresh contiguous memory in queue
+ * order, fixing up every link, so that a walk along the queue reads memory
+ * front to back.  Their strings are then packed as by q_compact_values when
+ * that is possible.  Elements moved in from other queues stay where they are.
+ * Return true if successful.
+ * Return false if q is NULL, if elements removed from it or moved to other
+ * queues are still out, or if the new memory could not be allocated.
+ */
+bool q_compact(struct list_head *head);
+
 /*
  * Return number of elements in queue.
  * Return 0 if q is NULL or empty
+ * Runs in constant time, as the descriptor keeps count.
  */
-int q_size(struct list_head *head);
+size_t q_size(struct list_head *head);
 
 /*
  * Delete the middle node in list.
@@ -93,6 +312,8 @@ int q_size(struct list_head *head);
  * If there're six element, the third member should be return.
  * Return true if successful.
  * Return false if list is NULL or empty.
+ * Runs in constant time while the middle cursor is maintained, see
+ * q_mid_enabled.
  *
  * Ref: https://leetcode.com/problems/delete-the-middle-node-of-a-linked-list/
  */
@@ -108,6 +329,15 @@ bool q_delete_mid(struct list_head *head);
  */
 bool q_delete_dup(struct list_head *head);
 
+/*
+ * Delete all nodes that have duplicate string, as q_delete_dup does, from a
+ * list in any order.  The nodes left keep their order.
+ * Return true if successful.
+ * Return false if list is NULL or empty, or if the table of strings seen
+ * could not be allocated, in which case the list is left unchanged.
+ */
+bool q_delete_dup_unsorted(struct list_head *head);
+
 /*
  * Attempt to swap every two adjacent nodes.
  *
@@ -115,12 +345,22 @@ bool q_delete_dup(struct list_head *head);
  */
 void q_swap(struct list_head *head);
 
+/*
+ * Relink the nodes so that head->next is the first element again, as code
+ * walking the list with list.h expects.  Only does work, O(n), if q_reverse
+ * was called an odd number of times since the last call.
+ * No effect if q is NULL.
+ */
+void q_straighten(struct list_head *head);
+
 /*
  * Reverse elements in queue
  * No effect if q is NULL or empty
  * This function should not allocate or free any list elements
  * (e.g., by calling q_insert_head, q_insert_tail, or q_remove_head).
  * It should rearrange the existing ones.
+ * Runs in constant time: it only flips queue_t.reversed, which the other
+ * operations honor.
  */
 void q_reverse(struct list_head *head);
 
@@ -0,0 +1,110 @@
+#include <pthread.h>
+#include <signal.h>
+
+/* The worker never allocates, it needs the harness for its own settings */
+#define INTERNAL 1
+#include "harness.h"
+#include "reclaim.h"
+
+static pthread_mutex_t jobs_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobs_added = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t jobs_done = PTHREAD_COND_INITIALIZER;
+static LIST_HEAD(jobs);
+/* Jobs submitted and not yet finished, including the running one */
+static unsigned long pending;
+static bool started;
+
+static pthread_mutex_t work_lock = PTHREAD_MUTEX_INITIALIZER;
+/*
+ * Whether the thread submitting jobs holds work_lock, so that a longjmp out
+ * of it can be followed by reclaim_unlock
+ */
+static bool holding;
+
+static void *reclaim_worker(void *arg)
+{
+    (void) arg;
+    /* Blocks reclaimed here went through a full structure walk already */
+    set_cautious_mode(false);
+    pthread_mutex_lock(&jobs_lock);
+    for (;;) {
+        while (list_empty(&jobs))
+            pthread_cond_wait(&jobs_added, &jobs_lock);
+        struct reclaim_job *job =
+            list_first_entry(&jobs, struct reclaim_job, link);
+        list_del(&job->link);
+        pthread_mutex_unlock(&jobs_lock);
+
+        pthread_mutex_lock(&work_lock);
+        job->run(job);
+        pthread_mutex_unlock(&work_lock);
+
+        pthread_mutex_lock(&jobs_lock);
+        if (!--pending)
+            pthread_cond_broadcast(&jobs_done);
+    }
+    return NULL;
+}
+
+/* Called with jobs_lock held */
+static bool reclaim_start(void)
+{
+    set_threaded_mode();
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    pthread_t tid;
+    started = !pthread_create(&tid, NULL, reclaim_worker, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (started)
+        pthread_detach(tid);
+    return started;
+}
+
+bool reclaim_submit(struct reclaim_job *job)
+{
+    pthread_mutex_lock(&jobs_lock);
+    bool ok = started || reclaim_start();
+    if (ok) {
+        list_add_tail(&job->link, &jobs);
+        pending++;
+        pthread_cond_signal(&jobs_added);
+    }
+    pthread_mutex_unlock(&jobs_lock);
+    return ok;
+}
+
+void reclaim_wait(void)
+{
+    pthread_mutex_lock(&jobs_lock);
+    while (pending)
+        pthread_cond_wait(&jobs_done, &jobs_lock);
+    pthread_mutex_unlock(&jobs_lock);
+}
+
+/* Until the worker exists there is nothing to exclude */
+void reclaim_lock(void)
+{
+    if (!started)
+        return;
+    pthread_mutex_lock(&work_lock);
+    holding = true;
+}
+
+void reclaim_unlock(void)
+{
+    if (!holding)
+        return;
+    holding = false;
+    pthread_mutex_unlock(&work_lock);
+}
+
+bool reclaim_trylock(void)
+{
+    if (!started)
+        return true;
+    if (pthread_mutex_trylock(&work_lock))
+        return false;
+    holding = true;
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef LAB0_RECLAIM_H
+#define LAB0_RECLAIM_H
+
+/*
+ * Background reclaimer.
+ *
+ * Jobs are run one at a time, in the order submitted, by a single worker
+ * thread started on the first submission.  Every job runs with the reclaim
+ * lock held, so code that touches what a job may be working on takes the
+ * same lock.  The worker starts with every signal blocked, so time limits
+ * and other signals of the test harness keep going to the main thread.
+ */
+
+#include <stdbool.h>
+
+#include "list.h"
+
+struct reclaim_job {
+    struct list_head link;
+    void (*run)(struct reclaim_job *job);
+};
+
+/*
+ * Queue job to be run by the worker, which may free the job's storage.
+ * Return false if the worker could not be started, in which case the
+ * caller keeps the job.
+ */
+bool reclaim_submit(struct reclaim_job *job);
+
+/* Wait until every job submitted so far has run */
+void reclaim_wait(void);
+
+/*
+ * Exclude jobs while held.  Must only be called from the thread that
+ * submits jobs.  reclaim_unlock does nothing unless the lock is held, so it
+ * also releases the lock after a longjmp out of a holder.
+ */
+void reclaim_lock(void);
+void reclaim_unlock(void);
+
+/* Take the lock as reclaim_lock, unless a job holds it: return false then */
+bool reclaim_trylock(void);
+
+#endif /* LAB0_RECLAIM_H */
@@ -222,6 +222,10 @@ void *calloc_or_fail(size_t cnt, size_t bytes, char *fun_name)
     return p;
 }
 
+/*
+ * Saved strings are preceded by their length, so that free_string can
+ * account for them without scanning them again.
+ */
 char *strsave_or_fail(char *s, char *fun_name)
 {
     if (!s)
@@ -229,7 +233,7 @@ char *strsave_or_fail(char *s, char *fun_name)
 
     size_t len = strlen(s);
     check_exceed(len + 1);
-    char *ss = malloc(len + 1);
+    size_t *ss = malloc(sizeof(size_t) + len + 1);
     if (!ss)
         fail_fun("strsave failed in %s", fun_name);
 
@@ -239,7 +243,8 @@ char *strsave_or_fail(char *s, char *fun_name)
     peak_bytes = MAX(peak_bytes, current_bytes);
     last_peak_bytes = MAX(last_peak_bytes, current_bytes);
 
-    return strncpy(ss, s, len + 1);
+    *ss = len;
+    return memcpy(ss + 1, s, len + 1);
 }
 
 /* Free block, as from malloc, realloc, or strsave */
@@ -269,9 +274,12 @@ void free_array(void *b, size_t cnt, size_t bytes)
 /* Free string saved by strsave_or_fail */
 void free_string(char *s)
 {
-    if (!s)
+    if (!s) {
         report_event(MSG_ERROR, "Attempting to free null block");
-    free_block((void *) s, strlen(s) + 1);
+        return;
+    }
+    size_t *ss = (size_t *) s - 1;
+    free_block(ss, *ss + 1);
 }
 
 /* Initialization of timers */
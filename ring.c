@@ -0,0 +1,322 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "ring.h"
+
+rqueue_t *rq_new()
+{
+    rqueue_t *q = malloc(sizeof(rqueue_t));
+    if (!q)
+        return NULL;
+    q->buf = NULL;
+    q->cap = q->first = q->size = 0;
+    q->reversed = false;
+    arena_init(&q->strs);
+    return q;
+}
+
+/* Copy s into the arena, or on its own if it is too long for the arena */
+static char *rq_value_new(rqueue_t *q, const char *s)
+{
+    size_t size = strlen(s) + 1;
+    char *v = size <= ARENA_MAX_ALLOC ? arena_alloc(&q->strs, size)
+                                      : malloc(size);
+    if (v)
+        memcpy(v, s, size);
+    return v;
+}
+
+/* Release a value of len characters obtained from rq_value_new */
+static void rq_value_free(rqueue_t *q, char *v, size_t len)
+{
+    if (len + 1 <= ARENA_MAX_ALLOC)
+        arena_free(&q->strs, v, len + 1);
+    else
+        free(v);
+}
+
+void rq_free(rqueue_t *q)
+{
+    if (!q)
+        return;
+    /* Only values too long for the arena were allocated one by one */
+    for (size_t i = 0; i < q->size; i++) {
+        char *v = rq_at(q, i);
+        if (strlen(v) + 1 > ARENA_MAX_ALLOC)
+            free(v);
+    }
+    free(q->buf);
+    arena_destroy(&q->strs);
+    free(q);
+}
+
+/* Make room for one more value, doubling the array when it is full */
+static bool rq_grow(rqueue_t *q)
+{
+    if (q->size < q->cap)
+        return true;
+    size_t cap = q->cap ? 2 * q->cap : RQ_MIN_CAPACITY;
+    char **buf = malloc(cap * sizeof(char *));
+    if (!buf)
+        return false;
+
+    /* Unwrap, keeping array order so that the direction stays valid */
+    size_t tail = q->cap - q->first;
+    if (tail > q->size)
+        tail = q->size;
+    if (q->size) {
+        memcpy(buf, q->buf + q->first, tail * sizeof(char *));
+        memcpy(buf + tail, q->buf, (q->size - tail) * sizeof(char *));
+    }
+    free(q->buf);
+    q->buf = buf;
+    q->cap = cap;
+    q->first = 0;
+    return true;
+}
+
+/* Put v before the first value in array order */
+static void rq_push_front(rqueue_t *q, char *v)
+{
+    q->first = (q->first - 1) & (q->cap - 1);
+    q->buf[q->first] = v;
+    q->size++;
+}
+
+/* Put v after the last value in array order */
+static void rq_push_back(rqueue_t *q, char *v)
+{
+    q->buf[(q->first + q->size) & (q->cap - 1)] = v;
+    q->size++;
+}
+
+static bool rq_insert(rqueue_t *q, char *s, bool at_head)
+{
+    if (!q || !s)
+        return false;
+    char *v = rq_value_new(q, s);
+    if (!v)
+        return false;
+    if (!rq_grow(q)) {
+        rq_value_free(q, v, strlen(v));
+        return false;
+    }
+    if (at_head != q->reversed)
+        rq_push_front(q, v);
+    else
+        rq_push_back(q, v);
+    return true;
+}
+
+bool rq_insert_head(rqueue_t *q, char *s)
+{
+    return rq_insert(q, s, true);
+}
+
+bool rq_insert_tail(rqueue_t *q, char *s)
+{
+    return rq_insert(q, s, false);
+}
+
+bool rq_insert_head_n(rqueue_t *q, char **s, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (!rq_insert_head(q, s[i])) {
+            while (i--)
+                rq_remove_head(q, NULL, 0);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool rq_insert_tail_n(rqueue_t *q, char **s, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (!rq_insert_tail(q, s[i])) {
+            while (i--)
+                rq_remove_tail(q, NULL, 0);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Copy a removed value out to the caller's buffer and release it */
+static void rq_hand_out(rqueue_t *q, char *v, char *sp, size_t bufsize)
+{
+    size_t len = strlen(v);
+    if (sp) {
+        size_t n = len > bufsize - 1 ? bufsize - 1 : len;
+        memcpy(sp, v, n);
+        sp[n] = '\0';
+    }
+    rq_value_free(q, v, len);
+}
+
+static bool rq_remove(rqueue_t *q, char *sp, size_t bufsize, bool at_head)
+{
+    if (!q || !q->size)
+        return false;
+    char *v;
+    if (at_head != q->reversed) {
+        v = q->buf[q->first];
+        q->first = (q->first + 1) & (q->cap - 1);
+    } else {
+        v = q->buf[(q->first + q->size - 1) & (q->cap - 1)];
+    }
+    q->size--;
+    rq_hand_out(q, v, sp, bufsize);
+    return true;
+}
+
+bool rq_remove_head(rqueue_t *q, char *sp, size_t bufsize)
+{
+    return rq_remove(q, sp, bufsize, true);
+}
+
+bool rq_remove_tail(rqueue_t *q, char *sp, size_t bufsize)
+{
+    return rq_remove(q, sp, bufsize, false);
+}
+
+size_t rq_size(rqueue_t *q)
+{
+    return q ? q->size : 0;
+}
+
+bool rq_delete_mid(rqueue_t *q)
+{
+    if (!q || !q->size)
+        return false;
+
+    /* Close the gap from whichever end of the array is nearer */
+    size_t n = q->size, mask = q->cap - 1;
+    size_t i = q->reversed ? n - 1 - n / 2 : n / 2;
+    char *v = q->buf[(q->first + i) & mask];
+    if (i < n / 2) {
+        for (; i; i--)
+            q->buf[(q->first + i) & mask] = q->buf[(q->first + i - 1) & mask];
+        q->first = (q->first + 1) & mask;
+    } else {
+        for (; i < n - 1; i++)
+            q->buf[(q->first + i) & mask] = q->buf[(q->first + i + 1) & mask];
+    }
+    q->size--;
+    rq_value_free(q, v, strlen(v));
+    return true;
+}
+
+bool rq_delete_dup(rqueue_t *q)
+{
+    if (!q || !q->size)
+        return false;
+
+    /* Survivors are written back over the logical positions already read */
+    size_t n = q->size, kept = 0;
+    for (size_t r = 0; r < n;) {
+        char *v = rq_at(q, r);
+        size_t run = 1;
+        while (r + run < n && !strcmp(rq_at(q, r + run), v)) {
+            rq_value_free(q, rq_at(q, r + run), strlen(v));
+            run++;
+        }
+        r += run;
+        if (run > 1)
+            rq_value_free(q, v, strlen(v));
+        else
+            q->buf[rq_slot(q, kept++)] = v;
+    }
+
+    /* Drop the logical tail, which is the array front when reversed */
+    if (q->reversed)
+        q->first = (q->first + n - kept) & (q->cap - 1);
+    q->size = kept;
+    return true;
+}
+
+void rq_swap(rqueue_t *q)
+{
+    if (!q)
+        return;
+    for (size_t i = 0; i + 1 < q->size; i += 2) {
+        size_t a = rq_slot(q, i), b = rq_slot(q, i + 1);
+        char *tmp = q->buf[a];
+        q->buf[a] = q->buf[b];
+        q->buf[b] = tmp;
+    }
+}
+
+void rq_reverse(rqueue_t *q)
+{
+    if (q)
+        q->reversed = !q->reversed;
+}
+
+static void rq_flip(char **lo, char **hi)
+{
+    while (lo < hi) {
+        char *tmp = *lo;
+        *lo++ = *hi;
+        *hi-- = tmp;
+    }
+}
+
+/* Below this many values, sort by insertion */
+#define RQ_SMALL_SORT 16
+
+/*
+ * Quicksort with the middle value as pivot, recursing into the smaller
+ * part so that the stack stays logarithmic.
+ */
+static void rq_quicksort(char **a, size_t n)
+{
+    while (n > RQ_SMALL_SORT) {
+        char *pivot = a[(n - 1) / 2];
+        size_t i = 0, j = n - 1;
+        for (;;) {
+            while (strcmp(a[i], pivot) < 0)
+                i++;
+            while (strcmp(a[j], pivot) > 0)
+                j--;
+            if (i >= j)
+                break;
+            char *tmp = a[i];
+            a[i++] = a[j];
+            a[j--] = tmp;
+        }
+        if (j + 1 < n - j - 1) {
+            rq_quicksort(a, j + 1);
+            a += j + 1;
+            n -= j + 1;
+        } else {
+            rq_quicksort(a + j + 1, n - j - 1);
+            n = j + 1;
+        }
+    }
+
+    for (size_t i = 1; i < n; i++) {
+        char *v = a[i];
+        size_t k = i;
+        for (; k && strcmp(a[k - 1], v) > 0; k--)
+            a[k] = a[k - 1];
+        a[k] = v;
+    }
+}
+
+void rq_sort(rqueue_t *q)
+{
+    if (!q || q->size < 2)
+        return;
+
+    /* Rotate the array in place so that the values start at slot 0 */
+    if (q->first) {
+        rq_flip(q->buf, q->buf + q->first - 1);
+        rq_flip(q->buf + q->first, q->buf + q->cap - 1);
+        rq_flip(q->buf, q->buf + q->cap - 1);
+        q->first = 0;
+    }
+    rq_quicksort(q->buf, q->size);
+    q->reversed = false;
+}
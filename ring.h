@@ -0,0 +1,103 @@
+#ifndef LAB0_RING_H
+#define LAB0_RING_H
+
+/*
+ * Ring buffer deque.
+ *
+ * Value pointers live in one circular array whose capacity is a power of
+ * two.  When the array is full it is replaced by one twice as large, with
+ * the values unwrapped to start at slot 0.  Reversal only flips the
+ * direction in which logical positions map onto the array, and sorting
+ * unwraps the array in place and sorts it as a plain C array.  Values are
+ * kept in a per-queue arena, as queue.c does for its long strings.
+ *
+ * The operations mirror those of queue.h.  There are no element_t objects,
+ * so removals copy the value out and release it in the same step.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+
+/* Capacity of the array allocated by the first insertion */
+#define RQ_MIN_CAPACITY 16
+
+typedef struct {
+    char **buf;
+    /* Capacity of buf, zero or a power of two */
+    size_t cap;
+    /* Slot of the first value in array order, and number of values */
+    size_t first, size;
+    /* Logical head is the last value in array order rather than the first */
+    bool reversed;
+    struct arena strs;
+} rqueue_t;
+
+/* Slot holding the value at logical position i, counting from the head */
+static inline size_t rq_slot(const rqueue_t *q, size_t i)
+{
+    if (q->reversed)
+        i = q->size - 1 - i;
+    return (q->first + i) & (q->cap - 1);
+}
+
+/* Value at logical position i, where i < size */
+static inline char *rq_at(const rqueue_t *q, size_t i)
+{
+    return q->buf[rq_slot(q, i)];
+}
+
+/* Create an empty queue.  Return NULL if could not allocate space. */
+rqueue_t *rq_new();
+
+/* Free all storage used by queue, no effect if q is NULL */
+void rq_free(rqueue_t *q);
+
+/*
+ * Insert a copy of s at head or tail of queue.
+ * Return false if q is NULL or could not allocate space.
+ */
+bool rq_insert_head(rqueue_t *q, char *s);
+bool rq_insert_tail(rqueue_t *q, char *s);
+
+/*
+ * Insert copies of s[0] .. s[n - 1] as rq_insert_head or rq_insert_tail
+ * would one at a time.  On failure the queue is left unchanged.
+ */
+bool rq_insert_head_n(rqueue_t *q, char **s, size_t n);
+bool rq_insert_tail_n(rqueue_t *q, char **s, size_t n);
+
+/*
+ * Remove the value at head or tail of queue.  If sp is non-NULL, copy the
+ * value to *sp, at most bufsize - 1 characters plus a null terminator.
+ * Return false if q is NULL or empty.
+ */
+bool rq_remove_head(rqueue_t *q, char *sp, size_t bufsize);
+bool rq_remove_tail(rqueue_t *q, char *sp, size_t bufsize);
+
+/* Return number of values in queue, 0 if q is NULL */
+size_t rq_size(rqueue_t *q);
+
+/*
+ * Delete the value at index size / 2, counting from 0 at the head.
+ * Return false if q is NULL or empty.
+ */
+bool rq_delete_mid(rqueue_t *q);
+
+/*
+ * Delete every value that occurs more than once in a sorted queue.
+ * Return false if q is NULL or empty.
+ */
+bool rq_delete_dup(rqueue_t *q);
+
+/* Swap every two adjacent values */
+void rq_swap(rqueue_t *q);
+
+/* Reverse the order of the values in constant time */
+void rq_reverse(rqueue_t *q);
+
+/* Sort values in ascending order.  Allocates and frees nothing. */
+void rq_sort(rqueue_t *q);
+
+#endif /* LAB0_RING_H */
@@ -0,0 +1,145 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "harness.h"
+#include "hugepage.h"
+#include "slab.h"
+
+/*
+ * Chunk header, kept in the first cache line of every chunk so that objects
+ * start on a line boundary.
+ */
+struct slab_chunk {
+    struct slab_chunk *next;
+    /* Pointer returned by malloc, before alignment, or NULL if huge */
+    void *raw;
+    /* Bytes of the chunk, this header included */
+    size_t size;
+};
+
+static inline uintptr_t align_up(uintptr_t x, uintptr_t a)
+{
+    return (x + a - 1) & ~(a - 1);
+}
+
+void slab_init(struct slab *s, size_t obj_size)
+{
+    /* Free objects hold the free list link in their first word */
+    if (obj_size < sizeof(void *))
+        obj_size = sizeof(void *);
+    s->obj_size = align_up(obj_size, sizeof(void *));
+    s->free_list = NULL;
+    s->bump = s->bump_end = NULL;
+    s->chunks = NULL;
+    s->spare = NULL;
+    s->live = 0;
+    s->huge = false;
+}
+
+/* Get a chunk, NULL if it could not be allocated */
+static struct slab_chunk *slab_new_chunk(struct slab *s)
+{
+    struct slab_chunk *c = s->huge ? huge_alloc(HUGE_PAGE_SIZE) : NULL;
+    if (c) {
+        c->raw = NULL;
+        c->size = HUGE_PAGE_SIZE;
+        return c;
+    }
+    void *raw = malloc(SLAB_CHUNK_SIZE + SLAB_ALIGN - 1);
+    if (!raw)
+        return NULL;
+    c = (struct slab_chunk *) align_up((uintptr_t) raw, SLAB_ALIGN);
+    c->raw = raw;
+    c->size = SLAB_CHUNK_SIZE;
+    return c;
+}
+
+/* Number of objects a chunk holds */
+static inline size_t slab_per_chunk(const struct slab *s,
+                                    const struct slab_chunk *c)
+{
+    return (c->size - SLAB_ALIGN) / s->obj_size;
+}
+
+static bool slab_grow(struct slab *s)
+{
+    struct slab_chunk *c = s->spare;
+    if (c)
+        s->spare = c->next;
+    else if (!(c = slab_new_chunk(s)))
+        return false;
+    c->next = s->chunks;
+    s->chunks = c;
+    s->bump = (char *) c + SLAB_ALIGN;
+    s->bump_end = (char *) c + c->size;
+    return true;
+}
+
+bool slab_reserve(struct slab *s)
+{
+    if (s->free_list || (size_t) (s->bump_end - s->bump) >= s->obj_size)
+        return true;
+    return slab_grow(s);
+}
+
+bool slab_reserve_n(struct slab *s, size_t n)
+{
+    size_t have = (size_t) (s->bump_end - s->bump) / s->obj_size;
+    struct slab_chunk **tail = &s->spare;
+    for (; *tail; tail = &(*tail)->next)
+        have += slab_per_chunk(s, *tail);
+    /* Append, so that the chunks are used in the order they were reserved */
+    while (have < n) {
+        struct slab_chunk *c = slab_new_chunk(s);
+        if (!c)
+            return false;
+        c->next = NULL;
+        *tail = c;
+        tail = &c->next;
+        have += slab_per_chunk(s, c);
+    }
+    return true;
+}
+
+void *slab_alloc(struct slab *s)
+{
+    void *obj = s->free_list;
+    if (obj) {
+        s->free_list = *(void **) obj;
+    } else {
+        if (!slab_reserve(s))
+            return NULL;
+        obj = s->bump;
+        s->bump += s->obj_size;
+    }
+    s->live++;
+    return obj;
+}
+
+void slab_free(struct slab *s, void *obj)
+{
+    *(void **) obj = s->free_list;
+    s->free_list = obj;
+    s->live--;
+}
+
+static void slab_free_chunks(struct slab_chunk *c)
+{
+    while (c) {
+        struct slab_chunk *next = c->next;
+        if (c->raw)
+            free(c->raw);
+        else
+            huge_free(c, c->size);
+        c = next;
+    }
+}
+
+void slab_destroy(struct slab *s)
+{
+    bool huge = s->huge;
+    slab_free_chunks(s->chunks);
+    slab_free_chunks(s->spare);
+    slab_init(s, s->obj_size);
+    s->huge = huge;
+}
@@ -0,0 +1,73 @@
+#ifndef LAB0_SLAB_H
+#define LAB0_SLAB_H
+
+/*
+ * Fixed-size object allocator.
+ *
+ * Objects are carved out of cache-line-aligned chunks.  Released objects are
+ * threaded on an intrusive free list and handed out again before any fresh
+ * space is used, so a busy queue settles into a steady state where inserting
+ * and removing never reach the underlying allocator.
+ *
+ * Chunks are obtained with malloc, so they are still tracked by the test
+ * harness: a slab that is not destroyed shows up as leaked blocks.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SLAB_ALIGN 64
+#define SLAB_CHUNK_SIZE (16 * 1024)
+
+struct slab_chunk;
+
+struct slab {
+    size_t obj_size;
+    void *free_list;
+    char *bump, *bump_end;
+    struct slab_chunk *chunks;
+    /* Chunks set aside by slab_reserve_n, used before calling malloc again */
+    struct slab_chunk *spare;
+    /* Number of objects handed out and not yet released */
+    size_t live;
+    /*
+     * Take chunks of HUGE_PAGE_SIZE from huge_alloc, falling back to malloc.
+     * Cleared by slab_init, kept by slab_destroy.
+     */
+    bool huge;
+};
+
+/* Prepare an empty slab for objects of obj_size bytes. Allocates nothing. */
+void slab_init(struct slab *s, size_t obj_size);
+
+/*
+ * Make sure the next allocation will not need a new chunk.
+ * Return false if a chunk was needed and could not be allocated.
+ */
+bool slab_reserve(struct slab *s);
+
+/*
+ * Make sure the next n allocations will not need a new chunk, not counting
+ * objects on the free list.  Reserved chunks are used in the order they were
+ * reserved, each from its lowest address up.
+ * Return false if the chunks could not be allocated; those that could are
+ * kept for later.
+ */
+bool slab_reserve_n(struct slab *s, size_t n);
+
+/*
+ * Return an object, or NULL if a new chunk was needed and could not be
+ * allocated.
+ */
+void *slab_alloc(struct slab *s);
+
+/* Put an object obtained from slab_alloc back on the free list */
+void slab_free(struct slab *s, void *obj);
+
+/*
+ * Release every chunk at once, regardless of how many objects are still
+ * handed out.  The slab is left empty and can be used again.
+ */
+void slab_destroy(struct slab *s);
+
+#endif /* LAB0_SLAB_H */
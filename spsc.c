@@ -0,0 +1,72 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "spsc.h"
+
+spsc_t *spsc_new(size_t capacity)
+{
+    size_t n = SPSC_BATCH;
+    while (n < capacity)
+        n *= 2;
+    spsc_t *r = aligned_alloc(64, sizeof(spsc_t));
+    if (!r)
+        return NULL;
+    memset(r, 0, sizeof(spsc_t));
+    r->slots = malloc(n * sizeof(element_t *));
+    if (!r->slots) {
+        free(r);
+        return NULL;
+    }
+    r->mask = n - 1;
+    return r;
+}
+
+void spsc_free(spsc_t *r)
+{
+    if (!r)
+        return;
+    free(r->slots);
+    free(r);
+}
+
+void spsc_flush(spsc_t *r)
+{
+    __atomic_store_n(&r->tail, r->tail_local, __ATOMIC_RELEASE);
+}
+
+bool spsc_insert_tail(spsc_t *r, element_t *e)
+{
+    if (r->tail_local - r->head_cache > r->mask) {
+        /* Full as far as we know: show the consumer all, then look again */
+        spsc_flush(r);
+        r->head_cache = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        if (r->tail_local - r->head_cache > r->mask)
+            return false;
+    }
+    r->slots[r->tail_local++ & r->mask] = e;
+    if (r->tail_local - r->tail >= SPSC_BATCH)
+        spsc_flush(r);
+    return true;
+}
+
+element_t *spsc_remove_head(spsc_t *r, char *sp, size_t bufsize)
+{
+    if (r->head_local == r->tail_cache) {
+        /* Empty as far as we know: give the producer all slots back first */
+        if (r->head != r->head_local)
+            __atomic_store_n(&r->head, r->head_local, __ATOMIC_RELEASE);
+        r->tail_cache = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        if (r->head_local == r->tail_cache)
+            return NULL;
+    }
+    element_t *e = r->slots[r->head_local++ & r->mask];
+    if (r->head_local - r->head >= SPSC_BATCH)
+        __atomic_store_n(&r->head, r->head_local, __ATOMIC_RELEASE);
+
+    if (sp && bufsize) {
+        size_t n = e->len < bufsize - 1 ? e->len : bufsize - 1;
+        memcpy(sp, e->value, n);
+        sp[n] = '\0';
+    }
+    return e;
+}
@@ -0,0 +1,66 @@
+#ifndef LAB0_SPSC_H
+#define LAB0_SPSC_H
+
+/*
+ * Wait-free single-producer, single-consumer ring of element_t pointers.
+ *
+ * One thread inserts and one thread removes; every call returns in a bounded
+ * number of steps, reporting a full or empty ring instead of waiting.  The
+ * index each side publishes sits on a cache line of its own, next to a
+ * private copy of the other side's index, so that a side only reads the
+ * other's line when its copy says the ring is full or empty.
+ *
+ * Publication is batched: the producer makes its insertions visible every
+ * SPSC_BATCH elements, and the consumer gives slots back as often.  A side
+ * also publishes whenever it finds the ring full or empty, so neither can
+ * wait on the other's unpublished batch, and the producer calls spsc_flush
+ * once it has nothing more to insert for a while.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "queue.h"
+
+/* Elements published at once by either side */
+#define SPSC_BATCH 32
+
+typedef struct {
+    /* Written by the consumer: slots up to head are free again */
+    size_t head __attribute__((aligned(64)));
+    size_t head_local, tail_cache;
+    /* Written by the producer: slots up to tail hold elements */
+    size_t tail __attribute__((aligned(64)));
+    size_t tail_local, head_cache;
+    /* Read by both, never written after spsc_new */
+    element_t **slots __attribute__((aligned(64)));
+    size_t mask;
+} spsc_t;
+
+/*
+ * Create an empty ring of at least capacity slots, rounded up to a power of
+ * two.  Return NULL if could not allocate space.
+ */
+spsc_t *spsc_new(size_t capacity);
+
+/* Free the ring, no effect if r is NULL.  Elements still in it are not. */
+void spsc_free(spsc_t *r);
+
+/*
+ * Insert e at tail, as q_insert_tail does with a string.  Producer only.
+ * Return false if the ring is full.
+ */
+bool spsc_insert_tail(spsc_t *r, element_t *e);
+
+/* Publish every element inserted so far.  Producer only. */
+void spsc_flush(spsc_t *r);
+
+/*
+ * Remove the element at head, as q_remove_head does: if sp is non-NULL,
+ * copy its string to *sp, at most bufsize - 1 characters plus a null
+ * terminator.  Consumer only.
+ * Return NULL if the ring is empty.
+ */
+element_t *spsc_remove_head(spsc_t *r, char *sp, size_t bufsize);
+
+#endif /* LAB0_SPSC_H */
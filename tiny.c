@@ -226,8 +226,10 @@ char *process(int fd, struct sockaddr_in *clientaddr)
 #ifdef LOG_ACCESS
     log_access(status, clientaddr, &req);
 #endif
-    char *ret = malloc(strlen(req.filename) + 1);
-    strncpy(ret, req.filename, strlen(req.filename) + 1);
+    /* p was left on the terminator */
+    size_t size = p - req.filename + 1;
+    char *ret = malloc(size);
+    memcpy(ret, req.filename, size);
 
     return ret;
 }
\ No newline at end of file
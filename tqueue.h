@@ -0,0 +1,232 @@
+#ifndef LAB0_TQUEUE_H
+#define LAB0_TQUEUE_H
+
+/*
+ * Typed queues.
+ *
+ * DEFINE_QUEUE(name, type, cmp) generates a queue of values of a fixed-size
+ * type.  Values are stored in the element itself rather than behind a
+ * char *, so inserting one costs a single element from a per-queue slab and
+ * no string allocation.  Elements are linked through list.h.
+ *
+ * cmp(a, b) takes two const type * and returns a negative, zero or positive
+ * int as *a orders before, equal to or after *b.  It is expanded into the
+ * sort and the deduplication, so that no comparison goes through a function
+ * pointer; TQ_CMP_NUM does for arithmetic types.
+ *
+ * The generated functions mirror queue.h, prefixed with name_:
+ *   name_t *name_new();
+ *   void name_free(name_t *q);
+ *   bool name_insert_head(name_t *q, type v);
+ *   bool name_insert_tail(name_t *q, type v);
+ *   bool name_remove_head(name_t *q, type *vp);
+ *   bool name_remove_tail(name_t *q, type *vp);
+ *   size_t name_size(name_t *q);
+ *   bool name_delete_dup(name_t *q);
+ *   void name_sort(name_t *q);
+ * They are static inline, so that a file pays only for those it calls.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "list.h"
+#include "slab.h"
+
+/* Comparison for arithmetic types, see DEFINE_QUEUE */
+#define TQ_CMP_NUM(a, b) ((*(a) > *(b)) - (*(a) < *(b)))
+
+#define DEFINE_QUEUE(name, type, cmp)                                       \
+    typedef struct {                                                        \
+        type value;                                                         \
+        struct list_head list;                                              \
+    } name##_element_t;                                                     \
+                                                                            \
+    typedef struct {                                                        \
+        struct list_head head;                                              \
+        size_t size;                                                        \
+        struct slab nodes;                                                  \
+    } name##_t;                                                             \
+                                                                            \
+    /* Create an empty queue.  Return NULL if could not allocate space. */  \
+    static inline name##_t *name##_new()                                    \
+    {                                                                       \
+        name##_t *q = malloc(sizeof(name##_t));                             \
+        if (!q)                                                             \
+            return NULL;                                                    \
+        INIT_LIST_HEAD(&q->head);                                           \
+        q->size = 0;                                                        \
+        slab_init(&q->nodes, sizeof(name##_element_t));                     \
+        return q;                                                           \
+    }                                                                       \
+                                                                            \
+    /* Free all storage used by queue, no effect if q is NULL */            \
+    static inline void name##_free(name##_t *q)                             \
+    {                                                                       \
+        if (!q)                                                             \
+            return;                                                         \
+        slab_destroy(&q->nodes);                                            \
+        free(q);                                                            \
+    }                                                                       \
+                                                                            \
+    /* Value held by node */                                                \
+    static inline type *name##_value(struct list_head *node)                \
+    {                                                                       \
+        return &list_entry(node, name##_element_t, list)->value;            \
+    }                                                                       \
+                                                                            \
+    /* Element holding v, NULL if could not allocate space */               \
+    static inline name##_element_t *name##_element_new(name##_t *q, type v) \
+    {                                                                       \
+        name##_element_t *e = q ? slab_alloc(&q->nodes) : NULL;             \
+        if (e) {                                                            \
+            e->value = v;                                                   \
+            q->size++;                                                      \
+        }                                                                   \
+        return e;                                                           \
+    }                                                                       \
+                                                                            \
+    /* Insert v at head.  Return false if q is NULL or out of space. */     \
+    static inline bool name##_insert_head(name##_t *q, type v)              \
+    {                                                                       \
+        name##_element_t *e = name##_element_new(q, v);                     \
+        if (!e)                                                             \
+            return false;                                                   \
+        list_add(&e->list, &q->head);                                       \
+        return true;                                                        \
+    }                                                                       \
+                                                                            \
+    /* Insert v at tail, as name_insert_head */                             \
+    static inline bool name##_insert_tail(name##_t *q, type v)              \
+    {                                                                       \
+        name##_element_t *e = name##_element_new(q, v);                     \
+        if (!e)                                                             \
+            return false;                                                   \
+        list_add_tail(&e->list, &q->head);                                  \
+        return true;                                                        \
+    }                                                                       \
+                                                                            \
+    /* Unlink node and release its element, copying the value to *vp */     \
+    static inline void name##_element_del(name##_t *q,                      \
+                                          struct list_head *node, type *vp) \
+    {                                                                       \
+        name##_element_t *e = list_entry(node, name##_element_t, list);     \
+        if (vp)                                                             \
+            *vp = e->value;                                                 \
+        list_del(node);                                                     \
+        slab_free(&q->nodes, e);                                            \
+        q->size--;                                                          \
+    }                                                                       \
+                                                                            \
+    /*                                                                      \
+     * Remove the value at head, copying it to *vp if vp is non-NULL.       \
+     * Return false if q is NULL or empty.                                  \
+     */                                                                     \
+    static inline bool name##_remove_head(name##_t *q, type *vp)            \
+    {                                                                       \
+        if (!q || list_empty(&q->head))                                     \
+            return false;                                                   \
+        name##_element_del(q, q->head.next, vp);                            \
+        return true;                                                        \
+    }                                                                       \
+                                                                            \
+    /* Remove the value at tail, as name_remove_head */                     \
+    static inline bool name##_remove_tail(name##_t *q, type *vp)            \
+    {                                                                       \
+        if (!q || list_empty(&q->head))                                     \
+            return false;                                                   \
+        name##_element_del(q, q->head.prev, vp);                            \
+        return true;                                                        \
+    }                                                                       \
+                                                                            \
+    /* Return number of values in queue, 0 if q is NULL */                  \
+    static inline size_t name##_size(name##_t *q)                           \
+    {                                                                       \
+        return q ? q->size : 0;                                             \
+    }                                                                       \
+                                                                            \
+    /*                                                                      \
+     * Delete every value that occurs more than once in a sorted queue.     \
+     * Return false if q is NULL.                                           \
+     */                                                                     \
+    static inline bool name##_delete_dup(name##_t *q)                       \
+    {                                                                       \
+        if (!q)                                                             \
+            return false;                                                   \
+        struct list_head *node = q->head.next;                              \
+        while (node != &q->head) {                                          \
+            struct list_head *next = node->next;                            \
+            bool dup = false;                                               \
+            while (next != &q->head &&                                      \
+                   !cmp(name##_value(node), name##_value(next))) {          \
+                struct list_head *gone = next;                              \
+                next = next->next;                                          \
+                name##_element_del(q, gone, NULL);                          \
+                dup = true;                                                 \
+            }                                                               \
+            if (dup)                                                        \
+                name##_element_del(q, node, NULL);                          \
+            node = next;                                                    \
+        }                                                                   \
+        return true;                                                        \
+    }                                                                       \
+                                                                            \
+    /*                                                                      \
+     * Merge the null-terminated sorted lists a and b, taking from a first  \
+     * on ties so that the sort is stable.  prev links are not maintained.  \
+     */                                                                     \
+    static inline struct list_head *name##_merge(struct list_head *a,       \
+                                                 struct list_head *b)       \
+    {                                                                       \
+        struct list_head *head = NULL, **tail = &head;                      \
+        while (a && b) {                                                    \
+            struct list_head **from =                                       \
+                cmp(name##_value(a), name##_value(b)) <= 0 ? &a : &b;       \
+            *tail = *from;                                                  \
+            tail = &(*from)->next;                                          \
+            *from = (*from)->next;                                          \
+        }                                                                   \
+        *tail = a ? a : b;                                                  \
+        return head;                                                        \
+    }                                                                       \
+                                                                            \
+    /*                                                                      \
+     * Sort values in ascending order of cmp, stably.  Allocates nothing.   \
+     * Bottom-up merge sort as list_sort in list_sort.h: pending holds      \
+     * sorted runs of power-of-two sizes, chained through prev.             \
+     */                                                                     \
+    static inline void name##_sort(name##_t *q)                             \
+    {                                                                       \
+        if (!q || q->head.next == q->head.prev)                             \
+            return;                                                         \
+        struct list_head *list = q->head.next, *pending = NULL;             \
+        q->head.prev->next = NULL;                                          \
+        for (size_t count = 0; list; count++) {                             \
+            struct list_head **tail = &pending;                             \
+            size_t bits;                                                    \
+            for (bits = count; bits & 1; bits >>= 1)                        \
+                tail = &(*tail)->prev;                                      \
+            if (bits) {                                                     \
+                struct list_head *a = *tail, *b = a->prev;                  \
+                a = name##_merge(b, a);                                     \
+                a->prev = b->prev;                                          \
+                *tail = a;                                                  \
+            }                                                               \
+            list->prev = pending;                                           \
+            pending = list;                                                 \
+            list = list->next;                                              \
+            pending->next = NULL;                                           \
+        }                                                                   \
+        for (list = NULL; pending; pending = pending->prev)                 \
+            list = name##_merge(pending, list);                             \
+                                                                            \
+        /* Restore the prev links and close the circle */                   \
+        struct list_head *prev = &q->head;                                  \
+        for (q->head.next = list; list; prev = list, list = list->next)     \
+            list->prev = prev;                                              \
+        prev->next = &q->head;                                              \
+        q->head.prev = prev;                                                \
+    }
+
+#endif /* LAB0_TQUEUE_H */
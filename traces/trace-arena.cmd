@@ -0,0 +1,16 @@
+# Compare teardown of queues holding strings too long to be inlined,
+# with values in the per-queue arena and with one malloc per value
+option fail 0
+option malloc 0
+option pool 1
+new
+ih aardvark_bear_dolphin_gerbil_jaguar 500000
+it meerkat_panda_squirrel_vulture_wolf 500000
+mem
+time free
+option pool 0
+new
+ih aardvark_bear_dolphin_gerbil_jaguar 500000
+it meerkat_panda_squirrel_vulture_wolf 500000
+mem
+time free
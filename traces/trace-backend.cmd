@@ -0,0 +1,22 @@
+# Time the operations of traces 14-16 on one backend
+# Run it with -b list, -b unrolled, -b ring and -b index to compare them
+option fail 0
+option malloc 0
+new
+time ih dolphin 1000000
+time it gerbil 1000000
+mem
+time size 1000
+time reverse
+time sort
+time dedup
+free
+new
+time ih RAND 500000
+mem
+time reverse
+time sort
+time swap
+time dm 1000
+time rhq 499000
+free
@@ -0,0 +1,31 @@
+# Rebuild a 500k-element queue from a snapshot instead of inserting again,
+# then share long strings between a snapshot and its clones
+option fail 0
+option malloc 0
+new
+time ih RAND 500000
+time snapshot
+time sort
+time restore
+time reverse
+time restore
+time dedup unsorted
+time restore
+free
+snapshot
+option intern 0
+new
+time ih abcdefghijklmnopqrstuvwxyz_0123456789 100000
+time it abcdefghijklmnopqrstuvwxyz_0123456789_x 100000
+mem
+time snapshot
+mem
+time restore
+mem
+time rh abcdefghijklmnopqrstuvwxyz_0123456789
+time rt abcdefghijklmnopqrstuvwxyz_0123456789_x
+free
+time restore
+free
+snapshot
+mem
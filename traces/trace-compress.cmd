@@ -0,0 +1,28 @@
+# Front-code a sorted queue: each string keeps only what it does not share
+# with the one before it, and comes back whole from prh and decompress.
+option fail 0
+option malloc 0
+new
+it RAND 500000
+sort
+mem
+time compress
+free
+mem
+new
+time decompress
+mem
+free
+new
+it carpet
+it carpenter
+it carp
+it car
+sort
+compress
+prh car
+prh carp
+decompress
+rh carpenter
+rh carpet
+free
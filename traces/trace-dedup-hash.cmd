@@ -0,0 +1,18 @@
+# Delete duplicates of a million elements: sort then dedup, against one
+# hashing pass that keeps the order
+option fail 0
+option malloc 0
+new
+ih RAND 800000
+ih dolphin 100000
+it gerbil 100000
+time sort
+time dedup
+free
+new
+ih RAND 800000
+ih dolphin 100000
+it gerbil 100000
+time dedup unsorted
+size
+free
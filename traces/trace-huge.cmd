@@ -0,0 +1,137 @@
+# Walk ten million elements in random order on 4 KiB pages, then on
+# 2 MiB pages.  Each million is shuffled on its own, as shuffle is too slow
+# for more, and the queues are concatenated.
+option fail 0
+option malloc 0
+option reclaim 1
+option huge 0
+new
+ih RAND 1000000
+shuffle
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+free
+pick 1
+mem
+time locality
+time locality
+free
+mem
+option huge 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+new
+ih RAND 1000000
+shuffle
+pick 1
+concat 1
+pick 1
+free
+pick 1
+mem
+time locality
+time locality
+free
@@ -0,0 +1,25 @@
+# Memory of a duplicate-heavy queue of long strings, copied and interned
+option fail 0
+option malloc 0
+option intern 0
+new
+time ih the_quick_brown_fox_jumps_over_the_lazy_dog_0001 100000
+time it the_quick_brown_fox_jumps_over_the_lazy_dog_0002 100000
+time ih the_quick_brown_fox_jumps_over_the_lazy_dog_0003 100000
+mem
+time sort
+time dedup
+free
+option intern 1
+new
+time ih the_quick_brown_fox_jumps_over_the_lazy_dog_0001 100000
+time it the_quick_brown_fox_jumps_over_the_lazy_dog_0002 100000
+time ih the_quick_brown_fox_jumps_over_the_lazy_dog_0003 100000
+mem
+time sort
+time dedup
+it the_quick_brown_fox_jumps_over_the_lazy_dog_0001
+it the_quick_brown_fox_jumps_over_the_lazy_dog_0001
+rh the_quick_brown_fox_jumps_over_the_lazy_dog_0001
+rh the_quick_brown_fox_jumps_over_the_lazy_dog_0001
+free
@@ -0,0 +1,34 @@
+# Sort and dedup strings that tie on the cached 8-byte key
+option fail 0
+option malloc 0
+new
+ih abcdefghz
+ih abcdefgh
+ih abcdefghij
+ih abcdefg
+ih abcdefghi
+ih abcdefgh
+ih abcdefghij
+ih abcdefgh0
+sort
+rh abcdefg
+rh abcdefgh
+rh abcdefgh
+rh abcdefgh0
+rh abcdefghi
+rh abcdefghij
+rh abcdefghij
+rh abcdefghz
+ih abcdefghz
+ih abcdefghij
+ih abcdefghij
+ih abcdefghi
+ih abcdefgh
+ih abcdefg
+ih abcdefg
+sort
+dedup
+rh abcdefgh
+rh abcdefghi
+rh abcdefghz
+free
@@ -0,0 +1,31 @@
+# Walk a shuffled queue before and after compact moves its elements and
+# strings into queue order
+option fail 0
+option malloc 0
+new
+ih RAND 400000
+it abcdefghijklmnopqrstuvwxyz 400000
+shuffle
+locality
+time show
+time swap
+time swap
+time compact
+locality
+time show
+time swap
+time swap
+time sort
+free
+# Elements split off to another queue are still out, so compact leaves the
+# queue as it is until they come back
+new
+pick 1
+new
+ih RAND 1000
+it abcdefghijklmnopqrstuvwxyz 1000
+split 1000 1
+compact
+concat 1
+compact
+locality
@@ -0,0 +1,11 @@
+# Memory per element for half a million short strings
+# Run it with -b list and -b index to compare element_t with compact nodes
+option fail 0
+option malloc 0
+new
+time ih RAND 500000
+mem
+time sort
+time reverse
+time rhq 500000
+free
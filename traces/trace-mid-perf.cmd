@@ -0,0 +1,24 @@
+# Latency of dm as the queue grows, with and without the middle cursor
+option fail 0
+option malloc 0
+option mid 1
+new
+ih dolphin 1000
+time dm 100
+new
+ih dolphin 100000
+time dm 100
+new
+ih dolphin 1000000
+time dm 100
+option mid 0
+new
+ih dolphin 1000
+time dm 100
+new
+ih dolphin 100000
+time dm 100
+new
+ih dolphin 1000000
+time dm 100
+free
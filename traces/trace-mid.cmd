@@ -0,0 +1,657 @@
+# Cross-check the middle cursor against the reference walk in qtest
+# on a random mix of operations; every single dm is verified
+option fail 0
+option malloc 0
+new
+it gnu
+rt
+ih bee 5
+it owl
+rh
+ih gnu 2
+ih ibis
+it bee 7
+sort
+rt
+rh
+ih gnu 5
+ih ant
+rh
+ih cat 2
+rh
+rh
+rh
+rt
+ih kiwi 5
+ih ibis
+dm
+rh
+rt
+it gnu 7
+dm
+it fox 3
+it lark
+dm
+ih ibis
+it lark
+it bee 7
+ih cat 2
+dm
+ih gnu 2
+ih mole
+rh
+dm
+dm
+it jay
+it bee 3
+dm
+sort
+it ant
+dm
+it kiwi 7
+dm
+it owl 3
+rt
+ih fox 2
+ih hen
+ih cat
+dm
+it bee 3
+ih ibis 2
+it newt
+it eel 7
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+rhq 3
+rt
+it cat
+ih dog
+rt
+ih cat 5
+it cat
+it jay
+rh
+sort
+rt
+rh
+rt
+rt
+ih gnu 5
+it bee 3
+it ant 3
+ih hen
+ih jay
+ih jay
+ih fox
+rt
+ih jay
+it fox
+rt
+it newt
+it hen 3
+it cat
+ih lark
+it ibis
+ih fox 5
+ih owl 5
+ih eel 5
+rhq 3
+reverse
+rt
+it owl
+ih ibis
+rh
+rh
+rt
+rt
+dm
+dm
+ih newt
+it dog
+rh
+it ant
+dm
+it lark
+rt
+it fox
+ih dog
+it dog
+it newt 7
+ih mole
+rt
+dm
+ih mole 2
+dm
+ih gnu
+dm
+it hen 3
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+it lark
+ih ant
+ih mole 2
+rt
+rt
+rh
+it cat
+rh
+ih mole
+rhq 3
+rt
+rh
+swap
+it newt
+reverse
+ih eel
+rh
+dm
+it gnu 7
+dm
+ih owl
+it newt 7
+swap
+it cat 7
+rh
+rh
+ih mole 2
+ih mole
+dm
+ih jay 2
+dm
+rh
+it ibis 7
+rh
+dm
+ih ant 5
+ih ant
+dm
+rh
+rh
+dm
+swap
+it ibis 7
+rt
+ih hen
+rh
+dm
+rh
+ih owl 5
+reverse
+swap
+swap
+reverse
+ih cat 2
+it hen 3
+it gnu
+ih mole
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+ih lark
+rt
+it owl
+ih dog 2
+dm
+ih cat 2
+rhq 3
+dm
+ih ibis 2
+it dog 3
+it lark
+it ibis
+it gnu
+it eel 7
+rh
+ih owl
+ih eel
+ih eel
+dm
+dm
+dm
+rt
+sort
+it owl 7
+rh
+it bee
+it gnu
+reverse
+it kiwi
+ih bee
+rt
+ih newt
+ih fox
+rhq 3
+it jay
+ih lark 5
+ih cat
+it dog
+swap
+rt
+rh
+ih ibis 2
+rt
+it eel
+ih lark
+rh
+rhq 3
+rh
+ih bee 2
+rt
+rt
+rt
+rh
+reverse
+rhq 3
+it dog
+it gnu
+rhq 3
+rhq 3
+dm
+ih gnu
+ih kiwi
+dm
+reverse
+rt
+it lark
+it cat 3
+ih ant 2
+it ibis
+it owl
+it cat
+ih bee 2
+it kiwi 7
+ih mole 5
+ih newt
+ih jay 2
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+ih eel
+it bee
+rh
+rh
+dm
+rt
+dm
+reverse
+it lark
+rhq 3
+ih kiwi 5
+ih kiwi 5
+it cat 7
+swap
+dm
+rh
+dm
+ih mole 5
+reverse
+rt
+rt
+ih ant
+ih bee
+it ibis 3
+ih kiwi
+rh
+ih ant
+it lark
+swap
+reverse
+ih bee 5
+dm
+it newt
+it dog
+dm
+rhq 3
+it bee 3
+it mole
+ih bee
+rh
+it jay
+rh
+ih hen
+it lark
+ih eel 2
+dm
+it hen 3
+dm
+rhq 3
+rh
+it owl
+it hen
+ih hen 5
+rhq 3
+it bee
+rh
+ih eel 5
+sort
+ih eel 5
+reverse
+dm
+ih gnu 2
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+ih hen
+rt
+it gnu
+it bee
+dm
+ih newt
+it lark
+ih eel
+it gnu 3
+rhq 3
+rh
+it mole 3
+it eel
+ih kiwi
+swap
+ih gnu
+rh
+ih mole
+sort
+reverse
+dm
+rt
+swap
+sort
+rh
+dm
+ih hen 2
+rt
+ih hen
+ih cat 5
+ih fox 2
+it lark
+dm
+rt
+it eel
+it bee 3
+ih bee
+ih ibis 2
+ih mole
+it ibis
+ih cat
+it fox
+ih mole
+rh
+reverse
+dm
+it lark 3
+rh
+it mole
+ih jay
+sort
+ih ibis 5
+rt
+reverse
+ih owl
+ih kiwi 2
+it newt
+dm
+sort
+ih lark 2
+dm
+dm
+sort
+it gnu
+swap
+swap
+rh
+it dog 3
+dm
+ih ibis
+rhq 3
+ih bee 2
+rh
+ih dog
+rh
+ih cat
+rt
+rh
+it bee
+ih jay 5
+ih dog
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+dm
+ih eel 5
+rhq 3
+size
+free
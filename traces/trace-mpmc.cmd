@@ -0,0 +1,8 @@
+# Lock-free queue of Michael and Scott: one thread alone first, as queue.c
+# would be used, then producers and consumers on threads of their own.
+# Every string must come out once, in the order its producer put it in.
+mpmc 1 0 200000
+mpmc 1 1 200000
+mpmc 4 4 100000
+mpmc 8 2 50000
+mpmc 2 8 200000
@@ -0,0 +1,28 @@
+# Queues of numbers from DEFINE_QUEUE keep each value inside its element,
+# against the string queue that stores the same values as text.
+option fail 0
+option malloc 0
+new
+time it RAND 500000
+mem
+time sort
+time dedup
+free
+nnew
+time nit RAND 500000
+mem
+time nsort
+time ndedup
+nfree
+nnew
+nit 4
+nit 2
+nit 4
+nih 9
+nit 1
+nsort
+ndedup
+nrh 1
+nrt 9
+nrh 2
+nfree
@@ -0,0 +1,14 @@
+# Compare insertion throughput and memory of pooled and malloc'ed elements
+# Pooled run goes first, since RSS hardly ever shrinks after a free
+option fail 0
+option malloc 0
+option pool 1
+new
+time ih dolphin 1000000
+mem
+free
+option pool 0
+new
+time ih dolphin 1000000
+mem
+free
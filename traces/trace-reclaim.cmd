@@ -0,0 +1,46 @@
+# Free a queue of two million elements on the command loop, then hand an
+# equal one to the background reclaimer and keep working while it runs
+option fail 0
+option malloc 0
+new
+ih dolphin 1000000
+it gerbil 1000000
+time free
+option reclaim 1
+new
+ih dolphin 1000000
+it gerbil 1000000
+time free
+new
+ih bear 1000
+time reverse
+time rh bear
+mem
+free
+option pool 0
+new
+ih dolphin 200000
+it gerbil 200000
+time free
+new
+ih gerbil 1000
+time rh gerbil
+mem
+free
+# The last element of a freed queue comes back while its job is still queued
+option pool 1
+new
+ih x
+pick 1
+new
+concat 1
+pick 1
+pick 2
+new
+ih big 2000000
+free
+pick 2
+free
+pick 1
+rh x
+free
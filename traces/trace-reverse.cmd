@@ -0,0 +1,19 @@
+# Reverse two million elements, which only flips the orientation flag, then
+# work at both ends and compact, which relinks the nodes once
+option fail 0
+option malloc 0
+new
+ih dolphin 1000000
+it gerbil 1000000
+time reverse
+time reverse
+time reverse
+time rh gerbil
+time rt dolphin
+time ih bear 10
+time dm
+time swap
+time compact
+time reverse
+time compact
+free
@@ -0,0 +1,22 @@
+# Move two million elements between queues without copying any of them
+option fail 0
+option malloc 0
+pick 1
+new
+pick 1
+new
+time ih RAND 2000000
+time split 1000000 1
+time concat 1
+time split 1999990 1
+time concat 1
+time reverse
+time split 10 1
+time concat 1
+time split 500000 1
+time concat 1
+time dm
+pick 1
+free
+pick 1
+time free
@@ -0,0 +1,4 @@
+# Hand elements from one thread to another through the wait-free ring, with
+# publication batched, and through a list behind a mutex for comparison.
+spsc 2000000
+spsc 2000000 64
@@ -0,0 +1,17 @@
+# Stream tens of millions of inserts without time limit or checks per
+# batch, as queues beyond 2^31 elements are built.  Counts past INT_MAX
+# are accepted: the split index below lies beyond the end of the queue.
+option fail 0
+option malloc 0
+option stream 1
+new
+time it x 30000000
+size
+pick 1
+new
+pick 1
+split 3000000000 1
+size
+time rhq 10000000
+size
+time free
@@ -0,0 +1,364 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "unrolled.h"
+
+uqueue_t *uq_new()
+{
+    uqueue_t *q = malloc(sizeof(uqueue_t));
+    if (!q)
+        return NULL;
+    INIT_LIST_HEAD(&q->nodes);
+    q->size = 0;
+    slab_init(&q->slab, sizeof(struct uq_node));
+    arena_init(&q->strs);
+    return q;
+}
+
+/* Copy s into the arena, or on its own if it is too long for the arena */
+static char *uq_value_new(uqueue_t *q, const char *s)
+{
+    size_t size = strlen(s) + 1;
+    char *v = size <= ARENA_MAX_ALLOC ? arena_alloc(&q->strs, size)
+                                      : malloc(size);
+    if (v)
+        memcpy(v, s, size);
+    return v;
+}
+
+/* Release a value of len characters obtained from uq_value_new */
+static void uq_value_free(uqueue_t *q, char *v, size_t len)
+{
+    if (len + 1 <= ARENA_MAX_ALLOC)
+        arena_free(&q->strs, v, len + 1);
+    else
+        free(v);
+}
+
+void uq_free(uqueue_t *q)
+{
+    if (!q)
+        return;
+    /* Only values too long for the arena were allocated one by one */
+    struct uq_node *node;
+    list_for_each_entry (node, &q->nodes, list) {
+        for (int i = node->start; i < node->start + node->count; i++) {
+            size_t len = strlen(node->values[i]);
+            if (len + 1 > ARENA_MAX_ALLOC)
+                free(node->values[i]);
+        }
+    }
+    slab_destroy(&q->slab);
+    arena_destroy(&q->strs);
+    free(q);
+}
+
+/* Allocate a node whose empty window sits at slot start */
+static struct uq_node *uq_node_new(uqueue_t *q, int start)
+{
+    struct uq_node *node = slab_alloc(&q->slab);
+    if (!node)
+        return NULL;
+    node->start = start;
+    node->count = 0;
+    return node;
+}
+
+static void uq_node_drop(uqueue_t *q, struct uq_node *node)
+{
+    list_del(&node->list);
+    slab_free(&q->slab, node);
+}
+
+bool uq_insert_head(uqueue_t *q, char *s)
+{
+    if (!q || !s)
+        return false;
+    char *v = uq_value_new(q, s);
+    if (!v)
+        return false;
+
+    struct uq_node *node = NULL;
+    if (!list_empty(&q->nodes))
+        node = list_first_entry(&q->nodes, struct uq_node, list);
+    if (!node || !node->start) {
+        /* Start the window at the end, leaving room for further heads */
+        node = uq_node_new(q, UQ_SLOTS);
+        if (!node) {
+            uq_value_free(q, v, strlen(v));
+            return false;
+        }
+        list_add(&node->list, &q->nodes);
+    }
+    node->values[--node->start] = v;
+    node->count++;
+    q->size++;
+    return true;
+}
+
+bool uq_insert_tail(uqueue_t *q, char *s)
+{
+    if (!q || !s)
+        return false;
+    char *v = uq_value_new(q, s);
+    if (!v)
+        return false;
+
+    struct uq_node *node = NULL;
+    if (!list_empty(&q->nodes))
+        node = list_last_entry(&q->nodes, struct uq_node, list);
+    if (!node || node->start + node->count == UQ_SLOTS) {
+        node = uq_node_new(q, 0);
+        if (!node) {
+            uq_value_free(q, v, strlen(v));
+            return false;
+        }
+        list_add_tail(&node->list, &q->nodes);
+    }
+    node->values[node->start + node->count++] = v;
+    q->size++;
+    return true;
+}
+
+bool uq_insert_head_n(uqueue_t *q, char **s, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (!uq_insert_head(q, s[i])) {
+            while (i--)
+                uq_remove_head(q, NULL, 0);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool uq_insert_tail_n(uqueue_t *q, char **s, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (!uq_insert_tail(q, s[i])) {
+            while (i--)
+                uq_remove_tail(q, NULL, 0);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Copy a removed value out to the caller's buffer and release it */
+static void uq_hand_out(uqueue_t *q, char *v, char *sp, size_t bufsize)
+{
+    size_t len = strlen(v);
+    if (sp) {
+        size_t n = len > bufsize - 1 ? bufsize - 1 : len;
+        memcpy(sp, v, n);
+        sp[n] = '\0';
+    }
+    uq_value_free(q, v, len);
+}
+
+bool uq_remove_head(uqueue_t *q, char *sp, size_t bufsize)
+{
+    if (!q || !q->size)
+        return false;
+    struct uq_node *node = list_first_entry(&q->nodes, struct uq_node, list);
+    char *v = node->values[node->start++];
+    if (!--node->count)
+        uq_node_drop(q, node);
+    q->size--;
+    uq_hand_out(q, v, sp, bufsize);
+    return true;
+}
+
+bool uq_remove_tail(uqueue_t *q, char *sp, size_t bufsize)
+{
+    if (!q || !q->size)
+        return false;
+    struct uq_node *node = list_last_entry(&q->nodes, struct uq_node, list);
+    char *v = node->values[node->start + --node->count];
+    if (!node->count)
+        uq_node_drop(q, node);
+    q->size--;
+    uq_hand_out(q, v, sp, bufsize);
+    return true;
+}
+
+size_t uq_size(uqueue_t *q)
+{
+    return q ? q->size : 0;
+}
+
+bool uq_delete_mid(uqueue_t *q)
+{
+    if (!q || !q->size)
+        return false;
+
+    /* Skip whole nodes until the one holding index size / 2 */
+    size_t idx = q->size / 2;
+    struct uq_node *node;
+    list_for_each_entry (node, &q->nodes, list) {
+        if (idx < node->count)
+            break;
+        idx -= node->count;
+    }
+
+    int slot = node->start + idx, end = node->start + node->count - 1;
+    uq_value_free(q, node->values[slot], strlen(node->values[slot]));
+    memmove(&node->values[slot], &node->values[slot + 1],
+            (end - slot) * sizeof(char *));
+    if (!--node->count)
+        uq_node_drop(q, node);
+    q->size--;
+    return true;
+}
+
+bool uq_delete_dup(uqueue_t *q)
+{
+    if (!q || !q->size)
+        return false;
+
+    /*
+     * Survivors are written back over the positions already read, so the
+     * window of every node keeps its place and only the tail is cut off.
+     */
+    struct uq_pos r = uq_first(q), w = r;
+    size_t left = q->size, kept = 0;
+    while (left) {
+        char *v = uq_value(r);
+        size_t run = 1;
+        left--;
+        uq_next(q, &r);
+        while (left && !strcmp(uq_value(r), v)) {
+            uq_value_free(q, uq_value(r), strlen(v));
+            run++;
+            left--;
+            uq_next(q, &r);
+        }
+        if (run > 1) {
+            uq_value_free(q, v, strlen(v));
+            continue;
+        }
+        uq_value(w) = v;
+        uq_next(q, &w);
+        kept++;
+    }
+
+    struct uq_node *node, *safe;
+    left = kept;
+    list_for_each_entry_safe (node, safe, &q->nodes, list) {
+        if (left >= node->count) {
+            left -= node->count;
+            continue;
+        }
+        node->count = left;
+        left = 0;
+        if (!node->count)
+            uq_node_drop(q, node);
+    }
+    q->size = kept;
+    return true;
+}
+
+void uq_swap(uqueue_t *q)
+{
+    if (!q || q->size < 2)
+        return;
+    struct uq_pos a = uq_first(q);
+    for (size_t i = 1; i < q->size; i += 2) {
+        struct uq_pos b = a;
+        uq_next(q, &b);
+        char *tmp = uq_value(a);
+        uq_value(a) = uq_value(b);
+        uq_value(b) = tmp;
+        a = b;
+        if (i + 1 < q->size)
+            uq_next(q, &a);
+    }
+}
+
+void uq_reverse(uqueue_t *q)
+{
+    if (!q)
+        return;
+    struct list_head *pos = &q->nodes;
+    do {
+        struct list_head *next = pos->next;
+        pos->next = pos->prev;
+        pos->prev = next;
+        pos = next;
+    } while (pos != &q->nodes);
+
+    struct uq_node *node;
+    list_for_each_entry (node, &q->nodes, list) {
+        char **lo = &node->values[node->start];
+        char **hi = lo + node->count - 1;
+        while (lo < hi) {
+            char *tmp = *lo;
+            *lo++ = *hi;
+            *hi-- = tmp;
+        }
+    }
+}
+
+/*
+ * Quicksort over the n values from lo to hi.  Hoare partitioning only ever
+ * steps positions forwards or backwards, which the node windows support
+ * without any index.  The pivot is the middle value, so sorted and reversed
+ * input split evenly, and runs of equal values are spread over both halves.
+ * The smaller half is sorted recursively and the larger one by looping, so
+ * the recursion depth stays logarithmic.
+ */
+static void uq_quicksort(uqueue_t *q,
+                         struct uq_pos lo,
+                         struct uq_pos hi,
+                         size_t n)
+{
+    while (n > 1) {
+        struct uq_pos i = lo, j = hi;
+        for (size_t k = (n - 1) / 2; k; k--)
+            uq_next(q, &i);
+        char *pivot = uq_value(i);
+
+        i = lo;
+        size_t ii = 0, jj = n - 1;
+        for (;;) {
+            while (strcmp(uq_value(i), pivot) < 0) {
+                uq_next(q, &i);
+                ii++;
+            }
+            while (strcmp(uq_value(j), pivot) > 0) {
+                uq_prev(q, &j);
+                jj--;
+            }
+            if (ii >= jj)
+                break;
+            char *tmp = uq_value(i);
+            uq_value(i) = uq_value(j);
+            uq_value(j) = tmp;
+            uq_next(q, &i);
+            ii++;
+            uq_prev(q, &j);
+            jj--;
+        }
+
+        /* [lo, j] holds jj + 1 values, the rest follow j */
+        struct uq_pos right = j;
+        uq_next(q, &right);
+        if (jj + 1 < n - jj - 1) {
+            uq_quicksort(q, lo, j, jj + 1);
+            lo = right;
+            n -= jj + 1;
+        } else {
+            uq_quicksort(q, right, hi, n - jj - 1);
+            hi = j;
+            n = jj + 1;
+        }
+    }
+}
+
+void uq_sort(uqueue_t *q)
+{
+    if (!q || q->size < 2)
+        return;
+    uq_quicksort(q, uq_first(q), uq_last(q), q->size);
+}
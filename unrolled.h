@@ -0,0 +1,148 @@
+#ifndef LAB0_UNROLLED_H
+#define LAB0_UNROLLED_H
+
+/*
+ * Unrolled linked list queue.
+ *
+ * Every node holds a short array of value pointers, so walking the queue
+ * follows one link per UQ_SLOTS values instead of one per value, and the
+ * pointers to be compared or swapped sit next to each other in memory.
+ * Values of a node occupy a window of its array; inserting at the head grows
+ * the window of the first node downwards, inserting at the tail grows the
+ * window of the last node upwards, and a node is released as soon as its
+ * window becomes empty.  Nodes are carved from a per-queue slab and values
+ * from a per-queue arena, as queue.c does for its elements.
+ *
+ * The operations mirror those of queue.h.  There are no element_t objects,
+ * so removals copy the value out and release it in the same step.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+#include "list.h"
+#include "slab.h"
+
+/* Values per node, chosen so that a node fills 256 bytes */
+#define UQ_SLOTS 29
+
+struct uq_node {
+    struct list_head list;
+    /* Values occupy slots [start, start + count) */
+    unsigned short start, count;
+    char *values[UQ_SLOTS];
+};
+
+typedef struct {
+    struct list_head nodes;
+    size_t size;
+    struct slab slab;
+    struct arena strs;
+} uqueue_t;
+
+/* Position of one value.  node is NULL once it moves past either end. */
+struct uq_pos {
+    struct uq_node *node;
+    int slot;
+};
+
+static inline struct uq_pos uq_first(uqueue_t *q)
+{
+    struct uq_pos p = {NULL, 0};
+    if (!list_empty(&q->nodes)) {
+        p.node = list_first_entry(&q->nodes, struct uq_node, list);
+        p.slot = p.node->start;
+    }
+    return p;
+}
+
+static inline struct uq_pos uq_last(uqueue_t *q)
+{
+    struct uq_pos p = {NULL, 0};
+    if (!list_empty(&q->nodes)) {
+        p.node = list_last_entry(&q->nodes, struct uq_node, list);
+        p.slot = p.node->start + p.node->count - 1;
+    }
+    return p;
+}
+
+static inline void uq_next(uqueue_t *q, struct uq_pos *p)
+{
+    if (++p->slot < p->node->start + p->node->count)
+        return;
+    if (p->node->list.next == &q->nodes) {
+        p->node = NULL;
+        return;
+    }
+    p->node = list_entry(p->node->list.next, struct uq_node, list);
+    p->slot = p->node->start;
+}
+
+static inline void uq_prev(uqueue_t *q, struct uq_pos *p)
+{
+    if (--p->slot >= p->node->start)
+        return;
+    if (p->node->list.prev == &q->nodes) {
+        p->node = NULL;
+        return;
+    }
+    p->node = list_entry(p->node->list.prev, struct uq_node, list);
+    p->slot = p->node->start + p->node->count - 1;
+}
+
+#define uq_value(p) ((p).node->values[(p).slot])
+
+/* Create an empty queue.  Return NULL if could not allocate space. */
+uqueue_t *uq_new();
+
+/* Free all storage used by queue, no effect if q is NULL */
+void uq_free(uqueue_t *q);
+
+/*
+ * Insert a copy of s at head or tail of queue.
+ * Return false if q is NULL or could not allocate space.
+ */
+bool uq_insert_head(uqueue_t *q, char *s);
+bool uq_insert_tail(uqueue_t *q, char *s);
+
+/*
+ * Insert copies of s[0] .. s[n - 1] as uq_insert_head or uq_insert_tail
+ * would one at a time.  On failure the queue is left unchanged.
+ */
+bool uq_insert_head_n(uqueue_t *q, char **s, size_t n);
+bool uq_insert_tail_n(uqueue_t *q, char **s, size_t n);
+
+/*
+ * Remove the value at head or tail of queue.  If sp is non-NULL, copy the
+ * value to *sp, at most bufsize - 1 characters plus a null terminator.
+ * Return false if q is NULL or empty.
+ */
+bool uq_remove_head(uqueue_t *q, char *sp, size_t bufsize);
+bool uq_remove_tail(uqueue_t *q, char *sp, size_t bufsize);
+
+/* Return number of values in queue, 0 if q is NULL */
+size_t uq_size(uqueue_t *q);
+
+/*
+ * Delete the value at index size / 2, counting from 0 at the head.
+ * Return false if q is NULL or empty.
+ */
+bool uq_delete_mid(uqueue_t *q);
+
+/*
+ * Delete every value that occurs more than once in a sorted queue.
+ * Return false if q is NULL or empty.
+ */
+bool uq_delete_dup(uqueue_t *q);
+
+/* Swap every two adjacent values */
+void uq_swap(uqueue_t *q);
+
+/* Reverse the order of the values.  Allocates and frees nothing. */
+void uq_reverse(uqueue_t *q);
+
+/* Sort values in ascending order.  Allocates and frees nothing. */
+void uq_sort(uqueue_t *q);
+
+#endif /* LAB0_UNROLLED_H */